@@ -0,0 +1,224 @@
+/*
+ accurip.c -- AccurateRip checksums;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       accurip.c
+ * \brief      AccurateRip checksums
+ */
+
+
+#include "config.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+
+#include "memory.h"
+#include "errors.h"
+#include "io.h"
+#include "crc.h"
+#include "ccd.h"
+#include "image.h"
+#include "accurip.h"
+
+
+/**
+ * Tell whether a track is the first or the last audio track of a
+ * disc.
+ *
+ * \param[in]  ccd    _CCD structure_;
+ * \param[in]  track  Track number;
+ * \param[in]  step   -1 to look for an audio track before TRACK, or
+ *                    1 to look for one after it;
+ *
+ * \return
+ * + !=0  there is no audio track that way;
+ * + =0   otherwise;
+ *
+ * \since 0.3
+ *
+ */
+
+static int accurip_edge (const struct ccd *ccd, int track, int step)
+  __attribute__ ((nonnull, pure));
+
+
+void
+accurip_init (struct accurip *sum, size_t samples, int first_flag,
+	      int last_flag)
+{
+  /* Assert the checksums are valid. */
+  assert (sum != NULL);
+
+  memset (sum, 0, sizeof (*sum));
+  sum->position = 1;
+
+  /* Leave the edges of the disc out. */
+  sum->first = first_flag
+    ? ACCURIP_SECTOR_SAMPLES * ACCURIP_SKIP_SECTORS : 1;
+  sum->last = last_flag
+    ? samples - ACCURIP_SECTOR_SAMPLES * ACCURIP_SKIP_SECTORS : samples;
+  if (samples < ACCURIP_SECTOR_SAMPLES * ACCURIP_SKIP_SECTORS && last_flag)
+    sum->last = 0;
+}
+
+void
+accurip_update (struct accurip *sum, const void *data, size_t length)
+{
+  const uint8_t *p = data;	/* Current sample; */
+  uint32_t count = length / 4;	/* Number of samples; */
+  uint32_t begin, end;		/* Positions checksummed, as a half
+				   open range; */
+  uint32_t v1 = 0, upper = 0;	/* Partial sums; */
+  uint32_t i;			/* Sample index; */
+
+  /* Assert the checksums are valid. */
+  assert (sum != NULL);
+
+  /* Assert the data is valid. */
+  assert (data != NULL);
+
+  sum->crc32 = crc32 (sum->crc32, data, count * 4);
+
+  /* Find which of these samples are checksummed. */
+  begin = sum->position > sum->first ? sum->position : sum->first;
+  end = sum->position + count;
+  if (end > sum->last + 1) end = sum->last + 1;
+
+  /* Weigh each sample by its position. */
+  for (i = begin; i < end; i++)
+    {
+      const uint8_t *s = p + 4 * (i - sum->position);
+      uint64_t product = (uint64_t) i
+	* (s[0] | s[1] << 8 | s[2] << 16 | (uint32_t) s[3] << 24);
+
+      v1 += (uint32_t) product;
+      upper += (uint32_t) (product >> 32);
+    }
+
+  sum->v1 += v1;
+  sum->upper += upper;
+  sum->v2 = sum->v1 + sum->upper;
+  sum->position += count;
+}
+
+int
+accurip_track (const struct ccd *ccd, FILE *image, int track,
+	       struct accurip *sum)
+{
+  char *buffer;			/* Read buffer; */
+  off_t start, end;		/* Track range in sectors; */
+  off_t size;			/* Disc image size in sectors; */
+  int next;			/* Next track number; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Assert the checksums are valid. */
+  assert (sum != NULL);
+
+  size = image_size (image);
+  if (size < 0) error_push (-1, "cannot checksum track %d", track);
+  size /= IMAGE_SECTOR_SIZE;
+
+  /* Gaps belong to the track before them, unless a data track
+     follows. */
+  if (ccd->TRACK[track].IndexEntries < 2 || ccd->TRACK[track].INDEX[1] < 0)
+    error_push (-1, "track %d has no INDEX 01", track);
+  start = ccd->TRACK[track].INDEX[1];
+
+  next = track + 1;
+  if (next > ccd->TrackEntries)
+    end = size;
+  else if (ccd->TRACK[next].MODE == 0 && ccd->TRACK[next].IndexEntries > 1
+	   && ccd->TRACK[next].INDEX[1] >= 0)
+    end = ccd->TRACK[next].INDEX[1];
+  else
+    end = image_track_start (ccd, next);
+
+  if (end > size) end = size;
+  if (end < start)
+    error_push (-1, "track %d overlaps track %d", track, next);
+
+  accurip_init (sum, (end - start) * ACCURIP_SECTOR_SAMPLES,
+		accurip_edge (ccd, track, -1), accurip_edge (ccd, track, 1));
+
+  if (fseeko (image, start * IMAGE_SECTOR_SIZE, SEEK_SET) == -1)
+    error_push_lib (fseeko, -1, "cannot checksum track %d", track);
+
+  buffer = xmalloc (IMAGE_BUFFER_SIZE);
+
+  /* Feed the whole track a buffer at a time. */
+  while (start < end)
+    {
+      size_t chunk = end - start < IMAGE_BUFFER_SIZE / IMAGE_SECTOR_SIZE
+	? end - start : IMAGE_BUFFER_SIZE / IMAGE_SECTOR_SIZE;
+
+      if (fread (buffer, IMAGE_SECTOR_SIZE, chunk, image) != chunk)
+	{
+	  free (buffer);
+	  error_push_lib (fread, -1, "cannot checksum track %d", track);
+	}
+
+      accurip_update (sum, buffer, chunk * IMAGE_SECTOR_SIZE);
+      start += chunk;
+    }
+
+  free (buffer);
+
+  /* Return success. */
+  return 0;
+}
+
+void
+accurip2stream (const struct ccd *ccd, const struct accurip *sums,
+		FILE *stream)
+{
+  int track;			/* Track number; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the checksums are valid. */
+  assert (sums != NULL);
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  xfprintf (stream, "Track\tAccurateRip v1\tAccurateRip v2\tCRC32\n");
+
+  for (track = 1; track <= ccd->TrackEntries; track++)
+    if (ccd->TRACK[track].MODE == 0)
+      xfprintf (stream, "%02d\t%08X\t%08X\t%08X\n", track,
+		sums[track].v1, sums[track].v2, sums[track].crc32);
+}
+
+static int
+accurip_edge (const struct ccd *ccd, int track, int step)
+{
+  for (track += step; track >= 1 && track <= ccd->TrackEntries; track += step)
+    if (ccd->TRACK[track].MODE == 0) return 0;
+
+  return 1;
+}
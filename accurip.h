@@ -0,0 +1,163 @@
+/*
+ accurip.h -- AccurateRip checksums;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       accurip.h
+ * \brief      AccurateRip checksums
+ */
+
+
+#ifndef CCD2CUE_ACCURIP_H
+#define CCD2CUE_ACCURIP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ccd.h"
+
+/**
+ * Number of stereo samples of a sector.
+ */
+
+#define ACCURIP_SECTOR_SAMPLES 588
+
+/**
+ * Number of sectors left out of the checksums at the beginning of
+ * the first track and at the end of the last one.
+ *
+ * Drives with different read offsets cannot agree on them.
+ *
+ */
+
+#define ACCURIP_SKIP_SECTORS 5
+
+/**
+ * Checksums of an audio track
+ *
+ * The AccurateRip checksums weigh every stereo sample, taken as a 32
+ * bit little endian integer, by its position in the track, counting
+ * from 1.  Version 1 adds up the lower 32 bits of each product, and
+ * version 2 both the lower and the upper 32 bits.  The CRC-32, as
+ * the CUETools database and EAC take it, covers every sample.
+ *
+ * The structure also holds the state of the calculation, so a track
+ * can be fed a buffer at a time.
+ *
+ */
+
+struct accurip
+{
+  uint32_t v1;			/**< AccurateRip v1 checksum. */
+  uint32_t v2;			/**< AccurateRip v2 checksum. */
+  uint32_t crc32;		/**< CRC-32 of the whole track. */
+  uint32_t position;		/**< Position of the next sample. */
+  uint32_t first;		/**< Position of the first sample
+				   checksummed. */
+  uint32_t last;		/**< Position of the last sample
+				   checksummed. */
+  uint32_t upper;		/**< Sum of the upper 32 bits of the
+				   products, kept apart from V1. */
+};
+
+/**
+ * Initialize the checksums of an audio track.
+ *
+ * \param[out]  sum         Checksums;
+ * \param[in]   samples     Number of stereo samples of the track;
+ * \param[in]   first_flag  Whether it is the first audio track;
+ * \param[in]   last_flag   Whether it is the last audio track;
+ *
+ * \since 0.3
+ *
+ * The first ::ACCURIP_SKIP_SECTORS sectors but one sample of the
+ * first track, and the last ::ACCURIP_SKIP_SECTORS sectors of the
+ * last track, are left out of the AccurateRip checksums.
+ *
+ */
+
+void accurip_init (struct accurip *sum, size_t samples, int first_flag,
+		   int last_flag)
+  __attribute__ ((nonnull));
+
+/**
+ * Feed audio samples to the checksums of an audio track.
+ *
+ * \param[in,out]  sum     Checksums;
+ * \param[in]      data    Stereo samples, 16 bit little endian;
+ * \param[in]      length  Length of DATA in bytes, a multiple of 4;
+ *
+ * \since 0.3
+ *
+ * The samples out of the checksummed range are only counted, so the
+ * weighing loop over the remaining ones has no branch and runs as
+ * wide as the target allows.
+ *
+ */
+
+void accurip_update (struct accurip *sum, const void *data, size_t length)
+  __attribute__ ((nonnull));
+
+/**
+ * Calculate the checksums of an audio track of a disc image.
+ *
+ * \param[in]   ccd     _CCD structure_;
+ * \param[in]   image   Disc image stream;
+ * \param[in]   track   Track number;
+ * \param[out]  sum     Checksums;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * As AccurateRip takes them, tracks span from their _INDEX 01_ to
+ * _INDEX 01_ of the next audio track, so gaps belong to the track
+ * they follow.  The last audio track spans up to the first sector of
+ * the next track, if any, or else up to the end of the disc image.
+ *
+ */
+
+int accurip_track (const struct ccd *ccd, FILE *image, int track,
+		   struct accurip *sum)
+  __attribute__ ((nonnull));
+
+/**
+ * Write the checksums of the audio tracks of a disc into a stream.
+ *
+ * \param[in]   ccd     _CCD structure_;
+ * \param[in]   sums    Checksums indexed by track number;
+ * \param[out]  stream  Output stream;
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ * \since 0.3
+ *
+ * One line is written for each audio track, with its number followed
+ * by its AccurateRip v1 and v2 checksums and its CRC-32, all in
+ * hexadecimal, after a heading line.
+ *
+ */
+
+void accurip2stream (const struct ccd *ccd, const struct accurip *sums,
+		     FILE *stream)
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_ACCURIP_H */
@@ -28,9 +28,18 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <ctype.h>
 #include <assert.h>
 
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
 #include "memory.h"
+#include "io.h"
 #include "i18n.h"
 #include "ccd.h"
 #include "errors.h"
@@ -88,18 +97,362 @@ static void ccd_init (struct ccd *ccd)
 static void ccd_TRACK_init (struct ccd_TRACK *TRACK)
   __attribute__ ((nonnull));
 
+/**
+ * Tell the number of tracks from the TOC of a ::ccd structure.
+ *
+ * \param[in]  ccd      CCD structure;
+ * \param[in]  entries  Number of "Entry" sections parsed so far;
+ *
+ * \return The greater of the number of track points, 1 to 99, and of
+ *         the last track number given by the A1 points, or 0.
+ *
+ * \since 0.3
+ *
+ * CloneCD writes the "Entry" sections before the "TRACK" ones, so
+ * this lets ::stream2ccd size its track array once.
+ *
+ */
+
+static int ccd_TOC_tracks (const struct ccd *ccd, int entries)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Parse a CDText "Entry" line.
+ *
+ * \param[in]   line    Line read from a _CCD sheet_ stream;
+ * \param[in]   length  Length of LINE;
+ * \param[out]  data    _CD-Text_ data to fill out;
+ *
+ * \return
+ * + =0  success
+ * + <0  LINE is not a canonical "Entry" line
+ *
+ * \since 0.3
+ *
+ * CloneCD writes every CDText entry as "Entry N=" followed by 16
+ * bytes in 2 digit hexadecimal, separated by single spaces.  Such
+ * lines, which make up most of a _CCD sheet_ with _CD-Text_, are
+ * decoded here at once instead of by 17 conversions of 'sscanf'.
+ * DATA is only written on success; any other layout is left to the
+ * generic parser.
+ *
+ * Where SSSE3 is available, the 48 characters are gathered by
+ * shuffles into high digits, low digits and separators, and all of
+ * them are checked and combined at once; elsewhere each digit is
+ * looked up in a table.
+ *
+ */
+
+static int ccd_CDText_Entry (const char *line, size_t length,
+			     struct cdt_data *data)
+  __attribute__ ((nonnull));
+
+/**
+ * Length of the hexadecimal text of a CDText "Entry" line.
+ *
+ * Each of the 16 bytes of a ::cdt_data takes 2 digits and a space,
+ * but the last one, which takes the line end instead.
+ *
+ */
+
+#define CCD_CDTEXT_HEX_LENGTH (3 * sizeof (struct cdt_data) - 1)
+
+/**
+ * Sections of a _CCD sheet_
+ */
+
+enum ccd_section
+  {
+    CCD_NONE,			/**< Before any section, or in an
+				   unknown or exceeding one. */
+    CCD_CLONECD,		/**< "CloneCD" section. */
+    CCD_DISC,			/**< "Disc" section. */
+    CCD_CDTEXT,			/**< "CDText" section. */
+    CCD_SESSION,		/**< "Session N" sections. */
+    CCD_ENTRY,			/**< "Entry N" (Toc) sections. */
+    CCD_TRACK			/**< "TRACK N" sections. */
+  };
+
+/**
+ * Kinds of values of _CCD sheet_ entries
+ */
+
+enum ccd_value
+  {
+    CCD_INT,			/**< Decimal integer. */
+    CCD_HEX,			/**< Hexadecimal integer. */
+    CCD_ALNUM,			/**< Alphanumeric string of a fixed
+				   maximum size. */
+    CCD_FLAGS,			/**< Space separated words. */
+    CCD_INDEX,			/**< "INDEX N" entry. */
+    CCD_CDTEXT_ENTRY,		/**< "Entry N" (CDText) entry. */
+    CCD_SESSIONS,		/**< "Sessions" entry. */
+    CCD_TOCENTRIES,		/**< "TocEntries" entry. */
+    CCD_ENTRIES			/**< "Entries" (CDText) entry. */
+  };
+
+/**
+ * _CCD sheet_ entry
+ *
+ * Each entry a section may hold is described by its name, the kind
+ * of its value and where the value goes, as an offset into the
+ * structure of its section.
+ *
+ */
+
+struct ccd_key
+{
+  const char *name;		/**< Entry name, without number. */
+  enum ccd_section section;	/**< Section it is legal in. */
+  enum ccd_value value;		/**< Kind of value. */
+  size_t offset;		/**< Offset of the field in the
+				   section structure. */
+  size_t size;			/**< Size of the field, for
+				   ::CCD_ALNUM values. */
+};
+
+/**
+ * Number of entries of the _CCD sheet_ vocabulary.
+ */
+
+#define CCD_KEYS 28
+
+/**
+ * Number of buckets of the perfect hash of ::ccd_key_find.
+ */
+
+#define CCD_KEY_BUCKETS 16
+
+/**
+ * _CCD sheet_ vocabulary
+ *
+ * The entries are grouped by section, in the order of
+ * ::ccd_section.  Every name is unique, so ::ccd_key_find finds an
+ * entry by its name alone, and then checks its section.
+ *
+ */
+
+static const struct ccd_key ccd_keys[CCD_KEYS] =
+  {
+    { "Version", CCD_CLONECD, CCD_INT,
+      offsetof (struct ccd_CloneCD, Version), 0 },
+
+    { "TocEntries", CCD_DISC, CCD_TOCENTRIES, 0, 0 },
+    { "Sessions", CCD_DISC, CCD_SESSIONS, 0, 0 },
+    { "DataTracksScrambled", CCD_DISC, CCD_INT,
+      offsetof (struct ccd_Disc, DataTracksScrambled), 0 },
+    { "CDTextLength", CCD_DISC, CCD_INT,
+      offsetof (struct ccd_Disc, CDTextLength), 0 },
+    { "CATALOG", CCD_DISC, CCD_ALNUM,
+      offsetof (struct ccd_Disc, CATALOG), sizeof (((struct ccd_Disc *) 0)->CATALOG) },
+
+    { "Entries", CCD_CDTEXT, CCD_ENTRIES, 0, 0 },
+    { "Entry", CCD_CDTEXT, CCD_CDTEXT_ENTRY, 0, 0 },
+
+    { "PreGapMode", CCD_SESSION, CCD_INT,
+      offsetof (struct ccd_Session, PreGapMode), 0 },
+    { "PreGapSubC", CCD_SESSION, CCD_INT,
+      offsetof (struct ccd_Session, PreGapSubC), 0 },
+
+    { "Session", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, Session), 0 },
+    { "Point", CCD_ENTRY, CCD_HEX, offsetof (struct ccd_Entry, Point), 0 },
+    { "ADR", CCD_ENTRY, CCD_HEX, offsetof (struct ccd_Entry, ADR), 0 },
+    { "Control", CCD_ENTRY, CCD_HEX, offsetof (struct ccd_Entry, Control), 0 },
+    { "TrackNo", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, TrackNo), 0 },
+    { "AMin", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, AMin), 0 },
+    { "ASec", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, ASec), 0 },
+    { "AFrame", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, AFrame), 0 },
+    { "ALBA", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, ALBA), 0 },
+    { "Zero", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, Zero), 0 },
+    { "PMin", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, PMin), 0 },
+    { "PSec", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, PSec), 0 },
+    { "PFrame", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, PFrame), 0 },
+    { "PLBA", CCD_ENTRY, CCD_INT, offsetof (struct ccd_Entry, PLBA), 0 },
+
+    { "MODE", CCD_TRACK, CCD_INT, offsetof (struct ccd_TRACK, MODE), 0 },
+    { "FLAGS", CCD_TRACK, CCD_FLAGS, offsetof (struct ccd_TRACK, FLAGS), 0 },
+    { "ISRC", CCD_TRACK, CCD_ALNUM,
+      offsetof (struct ccd_TRACK, ISRC), sizeof (((struct ccd_TRACK *) 0)->ISRC) },
+    { "INDEX", CCD_TRACK, CCD_INDEX, 0, 0 },
+  };
+
+/**
+ * Displacements of the perfect hash of ::ccd_key_find.
+ *
+ * The 32 bit FNV-1a hash H of each name of ::ccd_keys selects the
+ * bucket H % ::CCD_KEY_BUCKETS, whose displacement D puts the name in
+ * the slot ((H >> 16) + D) % ::CCD_KEYS of ::ccd_key_slot.  The
+ * displacements were found by trying, for each bucket from the
+ * fullest one, the least one that sends its names to free slots, so
+ * every name gets a slot of its own and no slot is left empty.  They
+ * must be searched again whenever ::ccd_keys changes, by running
+ * tools/ccdkeys.c, which prints this table and ::ccd_key_slot.
+ * Debug builds check them on the first parse, by ::ccd_keys_valid.
+ *
+ */
+
+static const uint8_t ccd_key_displace[CCD_KEY_BUCKETS] =
+  {
+    2, 2, 0, 0, 4, 0, 8, 5, 2, 0, 0, 13, 24, 0, 22, 0
+  };
+
+/**
+ * Indexes into ::ccd_keys of each slot of the perfect hash of
+ * ::ccd_key_find.
+ */
+
+static const uint8_t ccd_key_slot[CCD_KEYS] =
+  {
+    24, 13, 8, 7, 19, 4, 23, 12, 22, 10, 2, 18, 20, 15, 11, 25,
+    6, 26, 1, 3, 17, 21, 0, 14, 9, 27, 16, 5
+  };
+
+/**
+ * Parse a _CCD sheet_ stream section by section.
+ *
+ * \param[in]   stream  Input stream;
+ * \param[out]  ccd     Initialized CCD structure to fill out;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * The current section is tracked from its header, and each line is
+ * only looked up among the entries legal in it, by ::ccd_key_find.
+ * Entries out of their section are ignored, so the order of the
+ * sections does not matter and an entry of a section cannot be
+ * taken for one of another, like "Session" in an "Entry" section
+ * for "Sessions" in the "Disc" one.
+ *
+ */
+
+static int ccd_parse_sections (FILE *stream, struct ccd *ccd)
+  __attribute__ ((nonnull));
+
+/**
+ * Parse a _CCD sheet_ stream regardless of sections.
+ *
+ * \param[in]   stream  Input stream;
+ * \param[out]  ccd     Initialized CCD structure to fill out;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.2
+ *
+ * Every line is matched against every entry of every section, as
+ * entries are uniquely named in a correct _CCD sheet_.  This copes
+ * with sheets whose section headers are damaged or missing.
+ *
+ */
+
+static int ccd_parse_lenient (FILE *stream, struct ccd *ccd)
+  __attribute__ ((nonnull));
+
+/**
+ * Look up an entry of a section in ::ccd_keys.
+ *
+ * \param[in]  section  Current section;
+ * \param[in]  name     Entry name, not null terminated;
+ * \param[in]  length   Length of NAME;
+ *
+ * \return The entry, or NULL if SECTION has no such entry.
+ *
+ * \since 0.3
+ *
+ * NAME is hashed once, and the only entry it can be is compared with
+ * it, by means of a minimal perfect hash of the names of ::ccd_keys.
+ * tools/ccdbench.c times it against a linear scan of ::ccd_keys and
+ * the sscanf calls of ::ccd_parse_lenient.
+ *
+ */
+
+static const struct ccd_key *ccd_key_find (enum ccd_section section,
+					   const char *name, size_t length)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Hash an entry name for ::ccd_key_find.
+ *
+ * \param[in]  name    Entry name, not null terminated;
+ * \param[in]  length  Length of NAME;
+ *
+ * \return The 32 bit FNV-1a hash of NAME.
+ *
+ * \since 0.3
+ *
+ */
+
+static uint32_t ccd_key_hash (const char *name, size_t length)
+  __attribute__ ((nonnull, pure));
+
+#ifndef NDEBUG
+/**
+ * Check the perfect hash of ::ccd_key_find.
+ *
+ * \return 1 if every entry of ::ccd_keys is found by its name in its
+ *         section, or else 0.
+ *
+ * \since 0.3
+ *
+ * The check is done once, and its result remembered.  It catches
+ * ::ccd_key_displace and ::ccd_key_slot left behind by a change of
+ * ::ccd_keys, which would otherwise make ::ccd_key_find silently miss
+ * entries.
+ *
+ */
+
+static int ccd_keys_valid (void);
+#endif
+
+/**
+ * Add a track to a ::ccd structure.
+ *
+ * \param[in,out]  ccd        CCD structure;
+ * \param[in,out]  allocated  Tracks allocated in CCD;
+ * \param[in]      entries    Number of "Entry" sections parsed so far;
+ *
+ * \return The number of the new track.
+ *
+ * \since 0.3
+ *
+ * On the first track the array is sized for as many tracks as
+ * ::ccd_TOC_tracks tells, and it grows geometrically should there be
+ * more sections than that.
+ *
+ */
+
+static int ccd_TRACK_add (struct ccd *ccd, int *allocated, int entries)
+  __attribute__ ((nonnull));
+
+/**
+ * Reduce the arrays of a ::ccd structure to the sections found.
+ *
+ * \param[in,out]  ccd           CCD structure;
+ * \param[in]      Sessions      "Session" sections found;
+ * \param[in]      TocEntries    "Entry" (Toc) sections found;
+ * \param[in]      CDTextEntries "Entry" (CDText) entries found;
+ * \param[in]      allocated     Tracks allocated in CCD;
+ *
+ * \since 0.3
+ *
+ * If less sections or entries are found than announced, the arrays
+ * are reduced to the exact size that accommodates the found ones and
+ * the number of records is updated as if it were correctly supplied.
+ *
+ */
+
+static void ccd_trim (struct ccd *ccd, int Sessions, int TocEntries,
+		      int CDTextEntries, int allocated)
+  __attribute__ ((nonnull));
+
 
 int
-stream2ccd (FILE *stream, struct ccd *ccd)
+stream2ccd (FILE *stream, struct ccd *ccd, int lenient_flag)
 {
-  /* Entries counters; these are used for numbering the entries
-     successively in the resulting cue structure regardless of order
-     or gaps that could have in the input CCD stream. */
-  int Session = 0;		/* Session; starts from 1;*/
-  int TocEntry = -1;		/* Toc; starts from 0; */
-  int CDTextEntry = -1;		/* CDText; starts from 0; */
-  int TRACK = 0;		/* Track; starts from 1; */
-
   /* Assert the stream is valid. */
   assert (stream != NULL);
 
@@ -109,6 +462,22 @@ stream2ccd (FILE *stream, struct ccd *ccd)
   /* Initialize the CCD structure. */
   ccd_init (ccd);
 
+  return lenient_flag
+    ? ccd_parse_lenient (stream, ccd) : ccd_parse_sections (stream, ccd);
+}
+
+static int
+ccd_parse_lenient (FILE *stream, struct ccd *ccd)
+{
+  /* Entries counters; these are used for numbering the entries
+     successively in the resulting cue structure regardless of order
+     or gaps that could have in the input CCD stream. */
+  int Session = 0;		/* Session; starts from 1;*/
+  int TocEntry = -1;		/* Toc; starts from 0; */
+  int CDTextEntry = -1;		/* CDText; starts from 0; */
+  int TRACK = 0;		/* Track; starts from 1; */
+  int TRACKs = 0;		/* Tracks allocated; */
+
   /* Parse the whole stream. */
   while (!feof (stream))
     {
@@ -145,6 +514,19 @@ stream2ccd (FILE *stream, struct ccd *ccd)
       if (my_getline (&line, &line_size, stream) == -1 && errno != 0)
             error_push_lib (getline, -1, "cannot parse CCD sheet stream");
 
+      /* "Entry" (CDText) entries in the canonical layout are by far
+	 the most frequent lines and no other entry is spelled like
+	 them, so decode them right away and skip the generic parser
+	 below. */
+      if (line_size > 0 && CDTextEntry + 1 < ccd->CDText.Entries
+	  && ccd_CDText_Entry (line, line_size,
+			       &ccd->CDText.Entry[CDTextEntry + 1].data) == 0)
+	{
+	  CDTextEntry++;
+	  free (line);
+	  continue;
+	}
+
       /* Simple data --- these are data that do not need dynamic
 	 allocation; insert the value of each entry on the respective
 	 fields on ccd structure.  It is not enforced that entries be
@@ -308,22 +690,22 @@ stream2ccd (FILE *stream, struct ccd *ccd)
 	    {
 	      sscanf (line, " Entry %*d = %hhx %hhx %hhx %hhx %hhx %hhx %hhx \
 %hhx %hhx %hhx %hhx %hhx %hhx %hhx %hhx %hhx ",
-		      &ccd->CDText.Entry[CDTextEntry].type,
-		      &ccd->CDText.Entry[CDTextEntry].track,
-		      &ccd->CDText.Entry[CDTextEntry].sequence,
-		      &ccd->CDText.Entry[CDTextEntry].block,
-		      &ccd->CDText.Entry[CDTextEntry].text[0],
-		      &ccd->CDText.Entry[CDTextEntry].text[1],
-		      &ccd->CDText.Entry[CDTextEntry].text[2],
-		      &ccd->CDText.Entry[CDTextEntry].text[3],
-		      &ccd->CDText.Entry[CDTextEntry].text[4],
-		      &ccd->CDText.Entry[CDTextEntry].text[5],
-		      &ccd->CDText.Entry[CDTextEntry].text[6],
-		      &ccd->CDText.Entry[CDTextEntry].text[7],
-		      &ccd->CDText.Entry[CDTextEntry].text[8],
-		      &ccd->CDText.Entry[CDTextEntry].text[9],
-		      &ccd->CDText.Entry[CDTextEntry].text[10],
-		      &ccd->CDText.Entry[CDTextEntry].text[11]);
+		      &ccd->CDText.Entry[CDTextEntry].data.type,
+		      &ccd->CDText.Entry[CDTextEntry].data.track,
+		      &ccd->CDText.Entry[CDTextEntry].data.sequence,
+		      &ccd->CDText.Entry[CDTextEntry].data.block,
+		      &ccd->CDText.Entry[CDTextEntry].data.text[0],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[1],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[2],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[3],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[4],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[5],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[6],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[7],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[8],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[9],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[10],
+		      &ccd->CDText.Entry[CDTextEntry].data.text[11]);
 	    }
 	}
 
@@ -339,15 +721,8 @@ stream2ccd (FILE *stream, struct ccd *ccd)
 	 declaration header, allocate room for more one "Track"
 	 section in the ccd structure. */
       if (sscanf (line, " [ TRACK %d ] ", &TRACK_tmp) == 1)
-	{
-	  /* Count up this section on the track counter.  */
-	  ccd->TrackEntries = ++TRACK;
-	  /* Reallocate the track array to accommodate more one track
-	     in the structure.  */
-	  ccd->TRACK = xrealloc (ccd->TRACK, sizeof (*ccd->TRACK) * (TRACK + 1));
-	  /* Initialize the newly allocated track structure. */
-	  ccd_TRACK_init (&ccd->TRACK[TRACK]);
-	}
+	/* Count up this section on the track counter.  */
+	TRACK = ccd_TRACK_add (ccd, &TRACKs, TocEntry + 1);
 
       /* If you have already found a "Track" section header verify if
 	 the current line is one of its contents. */
@@ -395,43 +770,372 @@ stream2ccd (FILE *stream, struct ccd *ccd)
 		}
 	    }
 	}
+
+      free (line);
     }
 
-  /* If you have found less "Session" sections than informed on the
-     "Sessions" entry, reduce the allocated structure to the exact
-     size that accommodate the found sections and update the number of
-     records. */
-  if (Session < ccd->Disc.Sessions)
+  ccd_trim (ccd, Session, TocEntry + 1, CDTextEntry + 1, TRACKs);
+
+  /* Return success. */
+  return 0;
+}
+
+static int
+ccd_parse_sections (FILE *stream, struct ccd *ccd)
+{
+  /* Entries counters, as in ::ccd_parse_lenient. */
+  int Session = 0;		/* Session; starts from 1;*/
+  int TocEntry = -1;		/* Toc; starts from 0; */
+  int CDTextEntry = -1;		/* CDText; starts from 0; */
+  int TRACK = 0;		/* Track; starts from 1; */
+  int TRACKs = 0;		/* Tracks allocated; */
+  enum ccd_section section = CCD_NONE; /* Current section; */
+
+  /* Assert the perfect hash matches the vocabulary. */
+  assert (ccd_keys_valid ());
+
+  /* Parse the whole stream. */
+  for (;;)
     {
-      ccd->Session = xrealloc (ccd->Session,
-			       sizeof (*ccd->Session) * Session);
-      ccd->Disc.Sessions = Session;
+      char *line;		/* Last line read from stream; */
+      size_t line_size = 0;	/* Length of LINE; */
+      const char *p, *name;	/* Current character and entry name; */
+      size_t length;		/* Length of NAME; */
+      int header;		/* Whether LINE is a section header; */
+      int number = -1;		/* Number after NAME, if any; */
+      const struct ccd_key *key; /* Entry of NAME; */
+      char *base = NULL;	/* Structure of the current section; */
+      char *value, *end;	/* Entry value and its end; */
+
+      if (my_getline (&line, &line_size, stream) == -1)
+	{
+	  free (line);
+	  if (ferror (stream))
+	    error_push_lib (getline, -1, "cannot parse CCD sheet stream");
+	  break;
+	}
+
+      /* "Entry" lines in the canonical layout make up most of the
+	 "CDText" section, so decode them right away. */
+      if (section == CCD_CDTEXT && CDTextEntry + 1 < ccd->CDText.Entries
+	  && ccd_CDText_Entry (line, line_size,
+			       &ccd->CDText.Entry[CDTextEntry + 1].data) == 0)
+	{
+	  CDTextEntry++;
+	  free (line);
+	  continue;
+	}
+
+      /* Split the name, letters only, from the number of a section
+	 header or an entry. */
+      for (p = line; isspace ((unsigned char) *p); p++);
+      header = *p == '[';
+      if (header)
+	for (p++; isspace ((unsigned char) *p); p++);
+      for (name = p; isalpha ((unsigned char) *p); p++);
+      length = p - name;
+      while (isspace ((unsigned char) *p)) p++;
+      if (isdigit ((unsigned char) *p))
+	for (number = 0; isdigit ((unsigned char) *p); p++)
+	  if (number <= (INT_MAX - 9) / 10)
+	    number = number * 10 + (*p - '0');
+      while (isspace ((unsigned char) *p)) p++;
+
+      /* Section header; sections beyond the number announced are
+	 ignored, and so are unknown ones. */
+      if (header && *p == ']')
+	{
+	  section = CCD_NONE;
+	  if (length == 7 && memcmp (name, "CloneCD", 7) == 0)
+	    section = CCD_CLONECD;
+	  else if (length == 4 && memcmp (name, "Disc", 4) == 0)
+	    section = CCD_DISC;
+	  else if (length == 6 && memcmp (name, "CDText", 6) == 0)
+	    section = CCD_CDTEXT;
+	  else if (length == 7 && memcmp (name, "Session", 7) == 0
+		   && number >= 0 && Session < ccd->Disc.Sessions)
+	    {
+	      section = CCD_SESSION;
+	      Session++;
+	    }
+	  else if (length == 5 && memcmp (name, "Entry", 5) == 0
+		   && number >= 0 && TocEntry + 1 < ccd->Disc.TocEntries)
+	    {
+	      section = CCD_ENTRY;
+	      TocEntry++;
+	    }
+	  else if (length == 5 && memcmp (name, "TRACK", 5) == 0
+		   && number >= 0)
+	    {
+	      section = CCD_TRACK;
+	      TRACK = ccd_TRACK_add (ccd, &TRACKs, TocEntry + 1);
+	    }
+	  free (line);
+	  continue;
+	}
+
+      /* Entry; look it up among those legal in the section. */
+      key = !header && *p == '=' ? ccd_key_find (section, name, length) : NULL;
+      if (key == NULL)
+	{
+	  free (line);
+	  continue;
+	}
+
+      for (value = (char *) p + 1; isspace ((unsigned char) *value); value++);
+
+      switch (section)
+	{
+	case CCD_CLONECD: base = (char *) &ccd->CloneCD; break;
+	case CCD_DISC: base = (char *) &ccd->Disc; break;
+	case CCD_CDTEXT: base = (char *) &ccd->CDText; break;
+	case CCD_SESSION: base = (char *) &ccd->Session[Session]; break;
+	case CCD_ENTRY: base = (char *) &ccd->Entry[TocEntry]; break;
+	case CCD_TRACK: base = (char *) &ccd->TRACK[TRACK]; break;
+	case CCD_NONE: break;
+	}
+
+      switch (key->value)
+	{
+	case CCD_INT:
+	  {
+	    long l = strtol (value, &end, 10); /* Value; */
+	    if (end > value) *(int *) (base + key->offset) = l;
+	  }
+	  break;
+	case CCD_HEX:
+	  {
+	    unsigned long l = strtoul (value, &end, 16); /* Value; */
+	    if (end > value) *(unsigned int *) (base + key->offset) = l;
+	  }
+	  break;
+	case CCD_ALNUM:
+	  for (end = value; isalnum ((unsigned char) *end)
+		 && (size_t) (end - value) < key->size - 1; end++);
+	  if (end > value)
+	    {
+	      memcpy (base + key->offset, value, end - value);
+	      base[key->offset + (end - value)] = '\0';
+	    }
+	  break;
+	case CCD_FLAGS:
+	  for (end = value; isalnum ((unsigned char) *end) || *end == ' '; end++);
+	  if (end > value)
+	    {
+	      char **FLAGS = (char **) (base + key->offset); /* Field; */
+	      free (*FLAGS);
+	      *end = '\0';
+	      *FLAGS = array_remove_trailing_whitespace (xstrdup (value));
+	    }
+	  break;
+	case CCD_INDEX:
+	  {
+	    struct ccd_TRACK *t = &ccd->TRACK[TRACK]; /* Track; */
+	    long l = strtol (value, &end, 10); /* Value; */
+
+	    if (end == value || number < 0) break;
+	    /* Indexes 0 and 1 have their places; others are numbered
+	       on from 2, as in ::ccd_parse_lenient. */
+	    if (number > 1)
+	      {
+		t->INDEX = xrealloc (t->INDEX, sizeof (*t->INDEX)
+				     * ++t->IndexEntries);
+		number = t->IndexEntries - 1;
+	      }
+	    t->INDEX[number] = l;
+	  }
+	  break;
+	case CCD_CDTEXT_ENTRY:
+	  if (number < 0 || CDTextEntry + 1 >= ccd->CDText.Entries)
+	    break;
+	  CDTextEntry++;
+	  if (ccd_CDText_Entry (line, line_size,
+				&ccd->CDText.Entry[CDTextEntry].data) < 0)
+	    {
+	      uint8_t *byte = (uint8_t *) &ccd->CDText.Entry[CDTextEntry].data;
+	      size_t i;		/* Byte index; */
+
+	      /* Take as many bytes as there are, as 'sscanf' would. */
+	      for (i = 0; i < sizeof (struct cdt_data); i++, value = end)
+		{
+		  unsigned long l = strtoul (value, &end, 16); /* Byte; */
+		  if (end == value) break;
+		  byte[i] = l;
+		}
+	    }
+	  break;
+	case CCD_SESSIONS:
+	  {
+	    long l = strtol (value, &end, 10); /* Value; */
+	    if (end > value && l > 0 && ccd->Disc.Sessions == 0)
+	      {
+		ccd->Disc.Sessions = l;
+		ccd->Session = xmalloc (sizeof (*ccd->Session)
+					* (ccd->Disc.Sessions + 1));
+	      }
+	  }
+	  break;
+	case CCD_TOCENTRIES:
+	  {
+	    long l = strtol (value, &end, 10); /* Value; */
+	    if (end > value && l > 0 && ccd->Disc.TocEntries == 0)
+	      {
+		ccd->Disc.TocEntries = l;
+		ccd->Entry = xmalloc (sizeof (*ccd->Entry)
+				      * (ccd->Disc.TocEntries + 1));
+	      }
+	  }
+	  break;
+	case CCD_ENTRIES:
+	  {
+	    long l = strtol (value, &end, 10); /* Value; */
+	    if (end > value && l > 0 && ccd->CDText.Entries == 0)
+	      {
+		ccd->CDText.Entries = l;
+		ccd->CDText.Entry = xmalloc (sizeof (*ccd->CDText.Entry)
+					     * ccd->CDText.Entries);
+	      }
+	  }
+	  break;
+	}
+
+      free (line);
     }
 
-  /* If you have found less "Toc" sections than informed on the
-     "TocEntries" entry, reduce the allocated structure to the exact
-     size that accommodate the found sections and update the number of
-     records. */
-  if (TocEntry + 1 < ccd->Disc.TocEntries)
+  ccd_trim (ccd, Session, TocEntry + 1, CDTextEntry + 1, TRACKs);
+
+  /* Return success. */
+  return 0;
+}
+
+void
+ccd2stream (const struct ccd *ccd, FILE *stream)
+{
+  int i;			/* Entry, section or TRACK index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  xfprintf (stream, "[CloneCD]\nVersion=%d\n", ccd->CloneCD.Version);
+
+  xfprintf (stream, "[Disc]\nTocEntries=%d\nSessions=%d\n"
+	    "DataTracksScrambled=%d\nCDTextLength=%d\n",
+	    ccd->Disc.TocEntries, ccd->Disc.Sessions,
+	    ccd->Disc.DataTracksScrambled, ccd->Disc.CDTextLength);
+  if (ccd->Disc.CATALOG[0] != '\0')
+    xfprintf (stream, "CATALOG=%s\n", ccd->Disc.CATALOG);
+
+  if (ccd->CDText.Entries > 0)
     {
-      ccd->Entry = xrealloc (ccd->Entry,
-			     sizeof (*ccd->Entry) * (TocEntry + 1));
-      ccd->Disc.TocEntries = TocEntry + 1;
+      xfprintf (stream, "[CDText]\nEntries=%d\n", ccd->CDText.Entries);
+      for (i = 0; i < ccd->CDText.Entries; i++)
+	{
+	  const struct cdt_data *e = &ccd->CDText.Entry[i].data; /* Entry; */
+	  int j;		/* Text byte index; */
+
+	  xfprintf (stream, "Entry %d=%02x %02x %02x %02x", i,
+		    e->type, e->track, e->sequence, e->block);
+	  for (j = 0; j < 12; j++)
+	    xfprintf (stream, " %02x", e->text[j]);
+	  xfprintf (stream, "\n");
+	}
     }
 
-  /* If you have found less "Entry" (CDText) entries than informed on
-     the "Entries" (CDText) entry, reduce the allocated structure to
-     the exact size that accommodate the found sections and update the
-     number of records. */
-  if (CDTextEntry + 1 < ccd->CDText.Entries)
+  /* Sessions are numbered from 1 on, and entry 0 is never used. */
+  for (i = 1; i <= ccd->Disc.Sessions; i++)
+    xfprintf (stream, "[Session %d]\nPreGapMode=%d\nPreGapSubC=%d\n", i,
+	      ccd->Session[i].PreGapMode, ccd->Session[i].PreGapSubC);
+
+  for (i = 0; i < ccd->Disc.TocEntries; i++)
     {
-      ccd->CDText.Entry = xrealloc (ccd->CDText.Entry,
-				    sizeof (*ccd->CDText.Entry) * (CDTextEntry + 1));
-      ccd->CDText.Entries = CDTextEntry + 1;
+      const struct ccd_Entry *e = &ccd->Entry[i]; /* Entry; */
+
+      xfprintf (stream, "[Entry %d]\nSession=%d\nPoint=0x%02x\n"
+		"ADR=0x%02x\nControl=0x%02x\nTrackNo=%d\n"
+		"AMin=%d\nASec=%d\nAFrame=%d\nALBA=%d\nZero=%d\n"
+		"PMin=%d\nPSec=%d\nPFrame=%d\nPLBA=%d\n",
+		i, e->Session, e->Point, e->ADR, e->Control, e->TrackNo,
+		e->AMin, e->ASec, e->AFrame, e->ALBA, e->Zero,
+		e->PMin, e->PSec, e->PFrame, e->PLBA);
     }
 
-  /* Return success. */
-  return 0;
+  /* Tracks are numbered from 1 on, and entry 0 is never used. */
+  for (i = 1; i <= ccd->TrackEntries; i++)
+    {
+      const struct ccd_TRACK *TRACK = &ccd->TRACK[i]; /* Track; */
+      int j;			/* INDEX index; */
+
+      xfprintf (stream, "[TRACK %d]\nMODE=%d\n", i, TRACK->MODE);
+      if (TRACK->ISRC[0] != '\0')
+	xfprintf (stream, "ISRC=%s\n", TRACK->ISRC);
+      if (TRACK->FLAGS != NULL)
+	xfprintf (stream, "FLAGS=%s\n", TRACK->FLAGS);
+
+      /* Indexes past 1 are numbered on from 2, as ::stream2ccd
+	 appends them. */
+      for (j = 0; j < TRACK->IndexEntries; j++)
+	if (TRACK->INDEX[j] != -1)
+	  xfprintf (stream, "INDEX %d=%d\n", j, TRACK->INDEX[j]);
+    }
+}
+
+void
+ccd_free (struct ccd *ccd)
+{
+  int i;			/* TRACK index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Tracks are numbered from 1 on, and entry 0 is never used. */
+  for (i = 1; i <= ccd->TrackEntries; i++)
+    {
+      free (ccd->TRACK[i].INDEX);
+      free (ccd->TRACK[i].FLAGS);
+    }
+
+  free (ccd->TRACK);
+  free (ccd->Entry);
+  free (ccd->Session);
+  free (ccd->CDText.Entry);
+
+  ccd_init (ccd);
+}
+
+int
+ccd_leadout (const struct ccd *ccd)
+{
+  int leadout = -1;		/* Lead-out found so far; */
+  int i;			/* Entry index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Take the last lead-out of all. */
+  for (i = 0; i < ccd->Disc.TocEntries; i++)
+    if (ccd->Entry[i].Point == 0xa2 && ccd->Entry[i].PLBA > leadout)
+      leadout = ccd->Entry[i].PLBA;
+
+  return leadout;
+}
+
+enum ccd_disc_type
+ccd_disc_type (const struct ccd *ccd)
+{
+  int i;			/* Entry index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Take the first session's word for it. */
+  for (i = 0; i < ccd->Disc.TocEntries; i++)
+    if (ccd->Entry[i].Point == 0xa0)
+      return ccd->Entry[i].PSec;
+
+  return CCD_DISC_CDDA;
 }
 
 static void
@@ -477,3 +1181,279 @@ ccd_TRACK_init (struct ccd_TRACK *TRACK)
   TRACK->INDEX[1] = -1;
   TRACK->IndexEntries = 2;
 }
+
+static int
+ccd_TOC_tracks (const struct ccd *ccd, int entries)
+{
+  int points = 0;		/* Track points; */
+  int last = 0;			/* Last track number; */
+  int i;			/* Entry index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  for (i = 0; i < entries; i++)
+    if (ccd->Entry[i].Point >= 1 && ccd->Entry[i].Point <= 99)
+      points++;
+    else if (ccd->Entry[i].Point == 0xa1 && ccd->Entry[i].PMin > last)
+      last = ccd->Entry[i].PMin;
+
+  return points > last ? points : last;
+}
+
+static const struct ccd_key *
+ccd_key_find (enum ccd_section section, const char *name, size_t length)
+{
+  uint32_t hash = ccd_key_hash (name, length); /* Hash of NAME; */
+  const struct ccd_key *key;	/* Only entry NAME can be; */
+
+  /* Assert the name is valid. */
+  assert (name != NULL);
+
+  key = &ccd_keys[ccd_key_slot[((hash >> 16)
+				+ ccd_key_displace[hash % CCD_KEY_BUCKETS])
+			       % CCD_KEYS]];
+
+  if (key->section != section || strncmp (key->name, name, length) != 0
+      || key->name[length] != '\0')
+    return NULL;
+
+  return key;
+}
+
+static uint32_t
+ccd_key_hash (const char *name, size_t length)
+{
+  uint32_t hash = 2166136261u;	/* FNV-1a hash accumulator; */
+  size_t i;			/* Character index; */
+
+  for (i = 0; i < length; i++)
+    hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+
+  return hash;
+}
+
+#ifndef NDEBUG
+static int
+ccd_keys_valid (void)
+{
+  static int valid = -1;	/* Result of the check, once done; */
+  size_t i;			/* Entry index; */
+
+  if (valid >= 0) return valid;
+
+  valid = 1;
+  for (i = 0; i < CCD_KEYS; i++)
+    if (ccd_key_find (ccd_keys[i].section, ccd_keys[i].name,
+		      strlen (ccd_keys[i].name)) != &ccd_keys[i])
+      valid = 0;
+
+  return valid;
+}
+#endif
+
+static int
+ccd_TRACK_add (struct ccd *ccd, int *allocated, int entries)
+{
+  int TRACK = ++ccd->TrackEntries; /* New track; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  if (TRACK > *allocated)
+    {
+      *allocated = *allocated ? *allocated * 2 : ccd_TOC_tracks (ccd, entries);
+      if (*allocated < TRACK) *allocated = TRACK;
+      ccd->TRACK = xrealloc (ccd->TRACK, sizeof (*ccd->TRACK) * (*allocated + 1));
+    }
+
+  /* Initialize the newly allocated track structure. */
+  ccd_TRACK_init (&ccd->TRACK[TRACK]);
+
+  return TRACK;
+}
+
+static void
+ccd_trim (struct ccd *ccd, int Sessions, int TocEntries, int CDTextEntries,
+	  int allocated)
+{
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* "Session" sections are numbered from 1. */
+  if (Sessions < ccd->Disc.Sessions)
+    {
+      ccd->Session = xrealloc (ccd->Session,
+			       sizeof (*ccd->Session) * (Sessions + 1));
+      ccd->Disc.Sessions = Sessions;
+    }
+
+  if (TocEntries < ccd->Disc.TocEntries)
+    {
+      ccd->Entry = xrealloc (ccd->Entry, sizeof (*ccd->Entry) * TocEntries);
+      ccd->Disc.TocEntries = TocEntries;
+    }
+
+  /* "TRACK" sections are numbered from 1. */
+  if (ccd->TrackEntries < allocated)
+    ccd->TRACK = xrealloc (ccd->TRACK,
+			   sizeof (*ccd->TRACK) * (ccd->TrackEntries + 1));
+
+  if (CDTextEntries < ccd->CDText.Entries)
+    {
+      ccd->CDText.Entry = xrealloc (ccd->CDText.Entry,
+				    sizeof (*ccd->CDText.Entry) * CDTextEntries);
+      ccd->CDText.Entries = CDTextEntries;
+    }
+}
+
+#ifndef __SSSE3__
+/**
+ * Hexadecimal digit values.
+ *
+ * Valid digits have the bit 0x10 set besides their value in the lower
+ * nibble, so the values of a run of digits can be checked at once by
+ * ANDing them together.
+ *
+ */
+
+static const uint8_t ccd_hex[256] =
+  {
+    ['0'] 0x10, ['1'] 0x11, ['2'] 0x12, ['3'] 0x13, ['4'] 0x14,
+    ['5'] 0x15, ['6'] 0x16, ['7'] 0x17, ['8'] 0x18, ['9'] 0x19,
+    ['a'] 0x1a, ['b'] 0x1b, ['c'] 0x1c, ['d'] 0x1d, ['e'] 0x1e,
+    ['f'] 0x1f,
+    ['A'] 0x1a, ['B'] 0x1b, ['C'] 0x1c, ['D'] 0x1d, ['E'] 0x1e,
+    ['F'] 0x1f,
+  };
+#endif
+
+static int
+ccd_CDText_Entry (const char *line, size_t length, struct cdt_data *data)
+{
+  const char *end = line + length; /* End of LINE; */
+  const char *p = line;		   /* Current character; */
+
+  /* Assert the line is valid. */
+  assert (line != NULL);
+
+  /* Assert the CD-Text data is valid. */
+  assert (data != NULL);
+
+  /* Match the " Entry N = " prefix. */
+  while (p < end && isspace ((unsigned char) *p)) p++;
+  if (end - p < 5 || memcmp (p, "Entry", 5) != 0) return -1;
+  p += 5;
+  while (p < end && isspace ((unsigned char) *p)) p++;
+  if (p == end || !isdigit ((unsigned char) *p)) return -1;
+  while (p < end && isdigit ((unsigned char) *p)) p++;
+  while (p < end && isspace ((unsigned char) *p)) p++;
+  if (p == end || *p != '=') return -1;
+  p++;
+  while (p < end && isspace ((unsigned char) *p)) p++;
+
+  /* The hexadecimal text must be followed by the line end, so no
+     more bytes than those of the entry are given. */
+  if ((size_t) (end - p) < CCD_CDTEXT_HEX_LENGTH
+      || (p + CCD_CDTEXT_HEX_LENGTH < end
+	  && !isspace ((unsigned char) p[CCD_CDTEXT_HEX_LENGTH])))
+    return -1;
+
+#ifdef __SSSE3__
+  {
+    /* The text is 47 characters long, plus the line end; */
+    const __m128i *text = (const __m128i *) p;
+    __m128i t0 = _mm_loadu_si128 (text);
+    __m128i t1 = _mm_loadu_si128 (text + 1);
+    __m128i t2 = _mm_loadu_si128 (text + 2);
+    /* Positions of high digits, low digits and separators within
+       each of the three vectors; -1 gives zero. */
+    const __m128i hi0 = _mm_setr_epi8 (0, 3, 6, 9, 12, 15, -1, -1,
+				       -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i hi1 = _mm_setr_epi8 (-1, -1, -1, -1, -1, -1, 2, 5,
+				       8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i hi2 = _mm_setr_epi8 (-1, -1, -1, -1, -1, -1, -1, -1,
+				       -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i lo0 = _mm_setr_epi8 (1, 4, 7, 10, 13, -1, -1, -1,
+				       -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i lo1 = _mm_setr_epi8 (-1, -1, -1, -1, -1, 0, 3, 6,
+				       9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i lo2 = _mm_setr_epi8 (-1, -1, -1, -1, -1, -1, -1, -1,
+				       -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i sp0 = _mm_setr_epi8 (2, 5, 8, 11, 14, -1, -1, -1,
+				       -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i sp1 = _mm_setr_epi8 (-1, -1, -1, -1, -1, 1, 4, 7,
+				       10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i sp2 = _mm_setr_epi8 (-1, -1, -1, -1, -1, -1, -1, -1,
+				       -1, -1, 0, 3, 6, 9, 12, -1);
+    __m128i hi = _mm_or_si128 (_mm_or_si128 (_mm_shuffle_epi8 (t0, hi0),
+					     _mm_shuffle_epi8 (t1, hi1)),
+			       _mm_shuffle_epi8 (t2, hi2));
+    __m128i lo = _mm_or_si128 (_mm_or_si128 (_mm_shuffle_epi8 (t0, lo0),
+					     _mm_shuffle_epi8 (t1, lo1)),
+			       _mm_shuffle_epi8 (t2, lo2));
+    __m128i sp = _mm_or_si128 (_mm_or_si128 (_mm_shuffle_epi8 (t0, sp0),
+					     _mm_shuffle_epi8 (t1, sp1)),
+			       _mm_shuffle_epi8 (t2, sp2));
+    __m128i digit, alpha, is_digit, is_alpha;
+
+    /* Separators; the last lane is the line end, checked above. */
+    if ((_mm_movemask_epi8 (_mm_cmpeq_epi8 (sp, _mm_set1_epi8 (' ')))
+	 & 0x7FFF) != 0x7FFF)
+      return -1;
+
+    /* High digits. */
+    digit = _mm_sub_epi8 (hi, _mm_set1_epi8 ('0'));
+    alpha = _mm_sub_epi8 (_mm_or_si128 (hi, _mm_set1_epi8 (0x20)),
+			  _mm_set1_epi8 ('a'));
+    is_digit = _mm_cmpeq_epi8 (_mm_min_epu8 (digit, _mm_set1_epi8 (9)), digit);
+    is_alpha = _mm_cmpeq_epi8 (_mm_min_epu8 (alpha, _mm_set1_epi8 (5)), alpha);
+    if (_mm_movemask_epi8 (_mm_or_si128 (is_digit, is_alpha)) != 0xFFFF)
+      return -1;
+    hi = _mm_or_si128 (_mm_and_si128 (is_digit, digit),
+		       _mm_and_si128 (is_alpha,
+				      _mm_add_epi8 (alpha, _mm_set1_epi8 (10))));
+
+    /* Low digits. */
+    digit = _mm_sub_epi8 (lo, _mm_set1_epi8 ('0'));
+    alpha = _mm_sub_epi8 (_mm_or_si128 (lo, _mm_set1_epi8 (0x20)),
+			  _mm_set1_epi8 ('a'));
+    is_digit = _mm_cmpeq_epi8 (_mm_min_epu8 (digit, _mm_set1_epi8 (9)), digit);
+    is_alpha = _mm_cmpeq_epi8 (_mm_min_epu8 (alpha, _mm_set1_epi8 (5)), alpha);
+    if (_mm_movemask_epi8 (_mm_or_si128 (is_digit, is_alpha)) != 0xFFFF)
+      return -1;
+    lo = _mm_or_si128 (_mm_and_si128 (is_digit, digit),
+		       _mm_and_si128 (is_alpha,
+				      _mm_add_epi8 (alpha, _mm_set1_epi8 (10))));
+
+    /* Nibbles are below 16, so shifting 16 bit lanes does not carry
+       across bytes. */
+    _mm_storeu_si128 ((__m128i *) data,
+		      _mm_or_si128 (_mm_slli_epi16 (hi, 4), lo));
+  }
+#else
+  {
+    uint8_t byte[sizeof (struct cdt_data)]; /* Decoded bytes; */
+    uint8_t valid = 0x10;	/* AND of all digit values; */
+    size_t i;			/* Byte index; */
+
+    for (i = 0; i < sizeof (byte); i++)
+      {
+	uint8_t hi = ccd_hex[(unsigned char) p[3 * i]]; /* High digit; */
+	uint8_t lo = ccd_hex[(unsigned char) p[3 * i + 1]]; /* Low digit; */
+
+	valid &= hi & lo;
+	if (i + 1 < sizeof (byte) && p[3 * i + 2] != ' ')
+	  return -1;
+	byte[i] = (uint8_t) ((hi & 0x0f) << 4 | (lo & 0x0f));
+      }
+
+    if (!valid)
+      return -1;
+
+    memcpy (data, byte, sizeof (byte));
+  }
+#endif
+
+  return 0;
+}
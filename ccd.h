@@ -26,6 +26,8 @@
 #ifndef CCD2CUE_CCD_H
 #define CCD2CUE_CCD_H
 
+#include <stdio.h>
+
 #include "cdt.h"
 
 /* Each structure named according to ccd_SECTION regards the SECTION
@@ -73,8 +75,9 @@ struct ccd_CDText
 {
   int Entries;			/**< Number of "Entry" CDText
 				     entries; */
-  struct cdt_data *Entry;	/**< Array of "Entry" CDText
-				     entries; */
+  struct cdt_entry *Entry;	/**< Array of "Entry" CDText
+				     entries, laid out as in a _CDT
+				     file_; */
 };
 
 /**
@@ -170,9 +173,11 @@ struct ccd
 /**
  * Parse _CCD sheet_ stream into a _CCD sheet_ structure.
  *
- * \param[in]   stream  Input stream;
- * \param[out]  ccd     Pointer to a uninitialized ccd structure to
- *                      fill out;
+ * \param[in]   stream        Input stream;
+ * \param[out]  ccd           Pointer to a uninitialized ccd structure
+ *                            to fill out;
+ * \param[in]   lenient_flag  Whether to match every line against the
+ *                            entries of every section;
  *
  * \return
  * + =0  success
@@ -202,13 +207,110 @@ struct ccd
  * This function only fail on an obscure case where it is impossible
  * to read some line of the input stream.
  *
+ * The current section is tracked from its header, and only the
+ * entries legal in it are looked for, by a lookup in a table of the
+ * _CCD sheet_ vocabulary, so the order of the sections does not
+ * matter.  Sections beyond the number announced for them, and entries
+ * out of their section, are ignored.  With LENIENT_FLAG every line is
+ * matched against every entry regardless of sections instead, as
+ * entries are uniquely named, which copes with sheets whose section
+ * headers are damaged or missing.
+ *
  * \sa
  * - Next step:
  *   + ::ccd2cue
  *   + ::ccd2cdt
  *
  */
-int stream2ccd (FILE *stream, struct ccd *ccd)
+int stream2ccd (FILE *stream, struct ccd *ccd, int lenient_flag)
+  __attribute__ ((nonnull));
+
+/**
+ * Parse _CCD sheet_ structure into a _CCD sheet_ stream.
+ *
+ * \param[in]   ccd     _CCD structure_;
+ * \param[out]  stream  Output stream;
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ * \since 0.3
+ *
+ * This is the inverse of ::stream2ccd: every section the structure
+ * holds is written in the layout CloneCD uses, so that parsing the
+ * stream back gives the same structure.
+ *
+ * \sa
+ * - Previous step:
+ *   + ::cue2ccd
+ *
+ */
+
+void ccd2stream (const struct ccd *ccd, FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Free a _CCD structure_.
+ *
+ * \param[in]  ccd  _CCD structure_ filled out by ::stream2ccd;
+ *
+ * \since 0.3
+ *
+ * Every array the structure points to is freed, leaving it empty, as
+ * needed when many _CCD sheets are parsed in a row.  The structure
+ * itself is not freed.
+ *
+ */
+
+void ccd_free (struct ccd *ccd)
   __attribute__ ((nonnull));
 
+/**
+ * Get the lead-out of a _CCD structure_.
+ *
+ * \param[in]  ccd  _CCD structure_;
+ *
+ * \return The first sector of the lead-out, in frames, or -1 if there
+ *         is none.
+ *
+ * \since 0.3
+ *
+ * The lead-out is given by the _PLBA_ entry of the _Entry_ section
+ * whose _Point_ is 0xA2.  On multi-session discs, the lead-out of
+ * the last session is taken, as it closes the disc image.
+ *
+ */
+
+int ccd_leadout (const struct ccd *ccd)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Disc types
+ *
+ * The _PSec_ entry of the _Entry_ section whose _Point_ is 0xA0 tells
+ * the format of the disc.
+ *
+ */
+
+enum ccd_disc_type
+  {
+    CCD_DISC_CDDA = 0x00,	/**< CD-DA or CD-ROM. */
+    CCD_DISC_CDI = 0x10,	/**< CD-i. */
+    CCD_DISC_XA = 0x20		/**< CD-ROM XA. */
+  };
+
+/**
+ * Get the disc type of a _CCD structure_.
+ *
+ * \param[in]  ccd  _CCD structure_;
+ *
+ * \return The disc type of the first session, or ::CCD_DISC_CDDA if
+ *         the TOC does not tell.
+ *
+ * \since 0.3
+ *
+ */
+
+enum ccd_disc_type ccd_disc_type (const struct ccd *ccd)
+  __attribute__ ((nonnull, pure));
+
 #endif	/* CCD2CUE_CCD_H */
@@ -59,6 +59,8 @@
 #include <stdarg.h>
 #include <string.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 /* Use POSIX headers. */
 #include "argp.h"
@@ -67,6 +69,13 @@
 /* ccd2cue headers. */
 #include "i18n.h"
 #include "convert.h"
+#include "memory.h"
+#include "image.h"
+#include "sub.h"
+#include "accurip.h"
+#include "discid.h"
+#include "fingerprint.h"
+#include "toc.h"
 #include "io.h"
 #include "file.h"
 #include "ccd.h"
@@ -173,6 +182,8 @@ struct Arguments
 				   input CCD sheet file name. */
     const char *cue_name; 	/**< The output file name; the input
 				   CUE sheet file name. */
+    const char *sub_name;		/**< '--sub' argument. */
+    const char *write_sub_name;	/**< '--write-sub' argument. */
 //  int abs_fname_flag;		/**< Boolean. True if, and only if,
 //				   '--absolute-file-name' is
 //				   supplied. */
@@ -180,6 +191,50 @@ struct Arguments
 //				   possible needed but not supplied
 //				   file names.  \sa
 //				   make_reference_name */
+    int split_flag;		/**< Boolean. True if, and only if,
+				   '--split' is supplied. */
+    int swap_flag;		/**< Boolean. True if, and only if,
+				   '--swap' is supplied. */
+    int wave_flag;		/**< Boolean. True if, and only if,
+				   '--wave' is supplied. */
+    int cdg_flag;		/**< Boolean. True if, and only if,
+				   '--cdg' is supplied. */
+    int probe_flag;		/**< Boolean. True if, and only if,
+				   '--probe' is supplied. */
+    int gaps_flag;		/**< Boolean. True if, and only if,
+				   '--gaps' is supplied. */
+    int accurip_flag;		/**< Boolean. True if, and only if,
+				   '--accurip' is supplied. */
+    int cdtext_flag;		/**< Boolean. True if, and only if,
+				   '--cdtext' is supplied. */
+    int lenient_flag;		/**< Boolean. True if, and only if,
+				   '--lenient' is supplied. */
+    int discid_flag;		/**< Boolean. True if, and only if,
+				   '--discid' is supplied. */
+    int check_flag;		/**< Boolean. True if, and only if,
+				   '--check' is supplied. */
+    int reverse_flag;		/**< Boolean. True if, and only if,
+				   '--reverse' is supplied. */
+    int check_cdt_flag;		/**< Boolean. True if, and only if,
+				   '--check-cdt' is supplied. */
+    const char *repair_name;	/**< '--repair' argument: "fix" or
+				   "drop". */
+    int inspect_cdt_flag;	/**< Boolean. True if, and only if,
+				   '--inspect-cdt' is supplied. */
+    const char *build_name;	/**< '--index-build' argument. */
+    const char *query_name;	/**< '--index-query' argument. */
+    char **ccd_names;		/**< Non-option arguments; CCD sheet
+				   file names for '--discid',
+				   '--check', '--index-build' and
+				   '--index-query', CUE sheet file
+				   names for '--reverse', or CDT
+				   file names for '--check-cdt' and
+				   '--inspect-cdt'. */
+    int ccd_count;		/**< Number of non-option arguments. */
+    const char *format_name;	/**< '--format' argument: "cue", the
+				   default, or "toc". */
+    const char *offset_arg;	/**< '--offset' argument. */
+    long offset;		/**< '--offset' argument, in samples. */
     FILE *cue_stream; /**< CUE sheet input stream.  Opened by ::parse_opt. */
     FILE *ccd_stream; /**< CCD sheet output stream.  Opened by ::parse_opt. */
 //
@@ -188,10 +243,580 @@ struct Arguments
 
 char *my_make_reference_name(const char *name, int dummy) {
     char *refname = malloc(strlen(name) - 3);
-    return strncpy(refname, name, strlen(name) - 4);
+    strncpy(refname, name, strlen(name) - 4);
+    refname[strlen(name) - 4] = '\0';
+    return refname;
 }
 
 
+/**
+ * Print the identifiers of discs.
+ *
+ * \param[in] count  Number of CCD sheets;
+ * \param[in] names  CCD sheet file names;
+ *
+ * \return Exit status: EX_OK if every disc could be identified, or
+ *         else EX_DATAERR.
+ *
+ * A line is printed for each disc with its MusicBrainz disc ID, its
+ * freedb disc ID and the CCD sheet file name, separated by tabs.
+ * Discs that cannot be identified are reported on standard error and
+ * skipped.  Nothing but the CCD sheets is read.
+ */
+
+static int print_discids (int count, char *const names[])
+{
+    int status = EX_OK; /* Exit status; */
+    int i;              /* CCD sheet index; */
+
+    for (i = 0; i < count; i++)
+    {
+        FILE *stream = fopen (names[i], "r");  /* CCD sheet stream; */
+        struct ccd ccd;         /* CCD structure filled by stream2ccd; */
+        struct discid discid;   /* Identifiers filled by ccd2discid; */
+
+        if (stream == NULL || stream2ccd (stream, &ccd, arguments.lenient_flag) < 0
+            || ccd2discid (&ccd, &discid) < 0)
+        {
+            error_flush ();
+            fprintf (stderr, "%s: cannot identify disc\n", names[i]);
+            status = EX_DATAERR;
+        }
+        else
+            printf ("%s\t%08x\t%s\n", discid.musicbrainz,
+                    (unsigned int) discid.freedb, names[i]);
+
+        if (stream != NULL)
+        {
+            ccd_free (&ccd);
+            fclose (stream);
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Resolve the name of a file a CUE sheet refers to.
+ *
+ * \param[in] dir   Directory part of the CUE sheet's file name;
+ * \param[in] name  File name, as in the CUE sheet;
+ *
+ * \return The file name, relative to DIR unless NAME is absolute,
+ *         to be freed by the caller.
+ */
+
+static char *cue_file_path (const char *dir, const char *name)
+{
+    if (name[0] == '/' || name[0] == '\\'
+        || (name[0] != '\0' && name[1] == ':'))
+        return xstrdup (name);
+
+    return concat (dir, name, NULL);
+}
+
+/**
+ * Convert CUE sheets into CCD sheets.
+ *
+ * \param[in] count  Number of CUE sheets;
+ * \param[in] names  CUE sheet file names;
+ *
+ * \return Exit status: EX_OK if every CUE sheet could be converted,
+ *         or else EX_DATAERR.
+ *
+ * Each CCD sheet is written alongside its CUE sheet, with the ".ccd"
+ * extension, unless a file of that name already exists, and a line
+ * is printed for it with both names separated by a tab.  The files
+ * the CUE sheet refers to, relative to its own directory, are only
+ * looked at for their sizes, which must be whole numbers of
+ * sectors, but the CD-Text of its CDTEXTFILE is brought into the CCD
+ * sheet.  A CDT file that cannot be read is reported on standard
+ * error, and the CCD sheet is written without CD-Text.  CUE sheets that cannot be converted, or whose
+ * files cannot be found, are reported on standard error and skipped.
+ */
+
+static int reverse_cues (int count, char *const names[])
+{
+    int status = EX_OK; /* Exit status; */
+    int i;              /* CUE sheet index; */
+
+    for (i = 0; i < count; i++)
+    {
+        FILE *stream = fopen (names[i], "r");  /* CUE sheet stream; */
+        struct cue *cue = cue_init (1); /* CUE structure filled by
+                                           stream2cue; */
+        struct ccd ccd;         /* CCD structure filled by cue2ccd; */
+        long *sectors;          /* Size of each file in sectors; */
+        const char *base;       /* File name part of the CUE sheet's; */
+        char *dir;              /* Directory part of the CUE sheet's; */
+        char *ccd_name;         /* CCD sheet file name; */
+        int usable = 1;         /* Whether every file can be used; */
+        int f;                  /* FILE index; */
+
+        if (stream == NULL || stream2cue (stream, cue) < 0)
+        {
+            error_flush ();
+            fprintf (stderr, "%s: cannot parse CUE sheet\n", names[i]);
+            status = EX_DATAERR;
+            if (stream != NULL) fclose (stream);
+            cue_free (cue);
+            continue;
+        }
+        fclose (stream);
+
+        /* The files are relative to the CUE sheet. */
+        base = names[i] + strlen (names[i]);
+        while (base > names[i] && base[-1] != '/' && base[-1] != '\\')
+            base--;
+        dir = xmalloc (base - names[i] + 1);
+        memcpy (dir, names[i], base - names[i]);
+        dir[base - names[i]] = '\0';
+
+        sectors = xmalloc (sizeof (*sectors) * (cue->FileEntries + 1));
+        for (f = 0; usable && f < cue->FileEntries; f++)
+        {
+            char *path = cue_file_path (dir, cue->FILE[f].filename);
+            off_t size = image_file_size (path);
+
+            if (size < 0)
+            {
+                error_flush ();
+                fprintf (stderr, "%s: cannot find '%s'\n", names[i], path);
+                usable = 0;
+            }
+            else if (size % IMAGE_SECTOR_SIZE != 0)
+            {
+                fprintf (stderr, "%s: '%s' is not a whole number of sectors\n",
+                         names[i], path);
+                usable = 0;
+            }
+            else
+                sectors[f] = size / IMAGE_SECTOR_SIZE;
+            free (path);
+        }
+
+        if (!usable)
+        {
+            status = EX_DATAERR;
+            free (sectors);
+            free (dir);
+            cue_free (cue);
+            continue;
+        }
+
+        if (cue2ccd (cue, sectors, &ccd) < 0)
+        {
+            error_flush ();
+            fprintf (stderr, "%s: cannot convert CUE sheet\n", names[i]);
+            status = EX_DATAERR;
+        }
+        else
+        {
+            char *reference_name = my_make_reference_name (names[i], 0);
+            FILE *ccd_stream = NULL;    /* CCD sheet stream; */
+            int fd;             /* CCD sheet file descriptor; */
+
+            ccd_name = concat (reference_name, ".ccd", NULL);
+            free (reference_name);
+
+            /* The CDT file has the layout of the CD-Text of a CCD
+               sheet, so its entries are taken as they are. */
+            if (cue->CDTEXTFILE != NULL)
+            {
+                char *path = cue_file_path (dir, cue->CDTEXTFILE);
+                FILE *cdt_stream = fopen (path, "rb");  /* CDT stream; */
+                struct cdt cdt;         /* CDT structure filled by
+                                           stream2cdt; */
+
+                if (cdt_stream == NULL || stream2cdt (cdt_stream, &cdt) < 0)
+                {
+                    error_flush ();
+                    fprintf (stderr, "%s: cannot read CD-Text from '%s'\n",
+                             names[i], path);
+                    status = EX_DATAERR;
+                }
+                else
+                {
+                    ccd.CDText.Entry = cdt.entry;
+                    ccd.CDText.Entries = cdt.entries;
+                    ccd.Disc.CDTextLength = cdt.entries * sizeof (*cdt.entry);
+                }
+
+                if (cdt_stream != NULL) fclose (cdt_stream);
+                free (path);
+            }
+
+            /* Never overwrite a sheet, most likely the very one the CUE
+               sheet was made from, along with its CD-Text and TOC. */
+            fd = open (ccd_name, O_WRONLY | O_CREAT | O_EXCL, 0666);
+            if (fd >= 0)
+            {
+                ccd_stream = fdopen (fd, "w");
+                if (ccd_stream == NULL)
+                    close (fd);
+            }
+
+            if (fd < 0 && errno == EEXIST)
+            {
+                fprintf (stderr, "%s: '%s' already exists\n", names[i], ccd_name);
+                status = EX_CANTCREAT;
+            }
+            else if (ccd_stream == NULL)
+            {
+                fprintf (stderr, "%s: cannot create '%s'\n", names[i], ccd_name);
+                status = EX_CANTCREAT;
+            }
+            else
+            {
+                ccd2stream (&ccd, ccd_stream);
+                if (fclose (ccd_stream) == EOF)
+                {
+                    /* Leave no partial CCD sheet behind. */
+                    fprintf (stderr, "%s: cannot write '%s'\n", names[i], ccd_name);
+                    remove (ccd_name);
+                    status = EX_IOERR;
+                }
+                else
+                    printf ("%s\t%s\n", names[i], ccd_name);
+            }
+            free (ccd_name);
+        }
+
+        ccd_free (&ccd);
+        free (sectors);
+        free (dir);
+        cue_free (cue);
+    }
+
+    return status;
+}
+
+/**
+ * Check disc images against their CCD sheets.
+ *
+ * \param[in] count     Number of CCD sheets;
+ * \param[in] names     CCD sheet file names;
+ * \param[in] img_name  Disc image file name, or NULL to deduce it
+ *                      from each CCD sheet file name;
+ *
+ * \return Exit status: EX_OK if no problem was found, or else
+ *         EX_DATAERR.
+ *
+ * The machine-readable lines of ::image_check are printed for each
+ * disc.  A disc image that cannot be found is reported as _missing_.
+ */
+
+static int check_images (int count, char *const names[], const char *img_name)
+{
+    int status = EX_OK; /* Exit status; */
+    int i;              /* CCD sheet index; */
+
+    for (i = 0; i < count; i++)
+    {
+        FILE *stream = fopen (names[i], "r");  /* CCD sheet stream; */
+        struct ccd ccd;         /* CCD structure filled by stream2ccd; */
+        char *name;             /* Disc image file name; */
+        off_t size;             /* Disc image size; */
+
+        if (stream == NULL || stream2ccd (stream, &ccd, arguments.lenient_flag) < 0)
+        {
+            error_flush ();
+            fprintf (stderr, "%s: cannot parse CCD sheet\n", names[i]);
+            status = EX_DATAERR;
+            if (stream != NULL)
+            {
+                ccd_free (&ccd);
+                fclose (stream);
+            }
+            continue;
+        }
+        fclose (stream);
+
+        if (img_name != NULL)
+            name = xstrdup (img_name);
+        else
+        {
+            char *reference_name = my_make_reference_name (names[i], 0);
+            name = concat (reference_name, ".img", NULL);
+            free (reference_name);
+        }
+
+        size = image_file_size (name);
+        if (size < 0)
+        {
+            error_flush ();
+            printf ("%s\tmissing\t%d\t-1\n", name, ccd_leadout (&ccd));
+            status = EX_DATAERR;
+        }
+        else if (image_check (&ccd, size, name, stdout) > 0)
+            status = EX_DATAERR;
+
+        free (name);
+        ccd_free (&ccd);
+    }
+
+    return status;
+}
+
+/**
+ * Check the CRCs of CDT files, and optionally repair them.
+ *
+ * \param[in] count        Number of CDT files;
+ * \param[in] names        CDT file names;
+ * \param[in] repair_name  "fix" to store the right CRCs, "drop" to
+ *                         remove the bad entries, or NULL to leave
+ *                         the files untouched;
+ *
+ * \return Exit status: EX_OK if no bad entry was found, or else
+ *         EX_DATAERR.
+ *
+ * For each CDT file a line is printed with its name, the status, the
+ * number of entries and the number of bad ones, separated by tabs.
+ * The status is _ok_, _bad_, _fixed_ or _dropped_.  Then a line with
+ * the name, _crc_, the entry index, the stored CRC and the calculated
+ * one is printed for every bad entry.  A repaired file is replaced
+ * by means of ::cdt2file, so it is left as it was if it cannot be
+ * rewritten.
+ */
+
+static int check_cdts (int count, char *const names[], const char *repair_name)
+{
+    int status = EX_OK; /* Exit status; */
+    int i;              /* CDT file index; */
+
+    for (i = 0; i < count; i++)
+    {
+        FILE *stream = fopen (names[i], "rb");  /* CDT file stream; */
+        struct cdt cdt;         /* CDT structure filled by stream2cdt; */
+        uint16_t *crc;          /* Calculated CRCs; */
+        size_t bad;             /* Entries whose CRC does not match; */
+        const char *state;      /* Status of the file; */
+        size_t j;               /* Entry index; */
+
+        if (stream == NULL || stream2cdt (stream, &cdt) < 0)
+        {
+            error_flush ();
+            fprintf (stderr, "%s: cannot parse CDT file\n", names[i]);
+            status = EX_DATAERR;
+            if (stream != NULL)
+                fclose (stream);
+            continue;
+        }
+        fclose (stream);
+
+        crc = xmalloc (sizeof (*crc) * (cdt.entries + 1));
+        bad = cdt_check (&cdt, crc);
+        state = bad == 0 ? "ok" : "bad";
+
+        if (bad > 0)
+            status = EX_DATAERR;
+
+        /* Repair a copy, so the stored CRCs can still be reported. */
+        if (bad > 0 && repair_name != NULL)
+        {
+            struct cdt repaired;        /* Repaired copy of CDT; */
+            int drop_flag = strcmp (repair_name, "drop") == 0;
+
+            repaired.entries = cdt.entries;
+            repaired.entry = xmalloc (sizeof (*repaired.entry) * cdt.entries);
+            memcpy (repaired.entry, cdt.entry,
+                    sizeof (*repaired.entry) * cdt.entries);
+            cdt_repair (&repaired, crc, drop_flag);
+
+            if (cdt2file (&repaired, names[i]) < 0)
+            {
+                error_flush ();
+                fprintf (stderr, "%s: cannot rewrite CDT file, left as it was\n",
+                         names[i]);
+                status = EX_CANTCREAT;
+            }
+            else
+                state = drop_flag ? "dropped" : "fixed";
+
+            cdt_free (&repaired);
+        }
+
+        printf ("%s\t%s\t%lu\t%lu\n", names[i], state,
+                (unsigned long) cdt.entries, (unsigned long) bad);
+        for (j = 0; bad > 0 && j < cdt.entries; j++)
+            if ((cdt.entry[j].crc[0] << 8 | cdt.entry[j].crc[1]) != crc[j])
+                printf ("%s\tcrc\t%lu\t%02x%02x\t%04x\n", names[i],
+                        (unsigned long) j, cdt.entry[j].crc[0],
+                        cdt.entry[j].crc[1], crc[j]);
+
+        free (crc);
+        cdt_free (&cdt);
+    }
+
+    return status;
+}
+
+/**
+ * Inspect CDT files.
+ *
+ * \param[in] count  Number of CDT files;
+ * \param[in] names  CDT file names;
+ *
+ * \return Exit status: EX_OK if every CDT file is valid and has no bad
+ *         entry, or else EX_DATAERR.
+ *
+ * The JSON line of ::cdt_inspect is printed for each CDT file, so
+ * the output of a whole archive can be fed to JSON Lines tools.
+ */
+
+static int inspect_cdts (int count, char *const names[])
+{
+    int status = EX_OK; /* Exit status; */
+    int i;              /* CDT file index; */
+
+    for (i = 0; i < count; i++)
+    {
+        FILE *stream = fopen (names[i], "rb");  /* CDT file stream; */
+
+        if (stream == NULL)
+        {
+            fprintf (stderr, "%s: cannot open CDT file\n", names[i]);
+            status = EX_DATAERR;
+            continue;
+        }
+
+        if (cdt_inspect (stream, names[i], stdout) != 0)
+        {
+            error_flush ();
+            status = EX_DATAERR;
+        }
+        fclose (stream);
+    }
+
+    return status;
+}
+
+/**
+ * Parse the TOC of a CCD sheet and take its fingerprint.
+ *
+ * \param[in]   name         CCD sheet file name;
+ * \param[out]  fingerprint  Fingerprint;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure, reported on standard error
+ */
+
+static int read_fingerprint (const char *name, uint64_t *fingerprint)
+{
+    FILE *stream = fopen (name, "r");   /* CCD sheet stream; */
+    struct ccd ccd;     /* CCD structure filled by stream2ccd; */
+    int status = 0;     /* Return status; */
+
+    if (stream == NULL || stream2ccd (stream, &ccd, arguments.lenient_flag) < 0
+        || ccd2fingerprint (&ccd, fingerprint) < 0)
+    {
+        error_flush ();
+        fprintf (stderr, "%s: cannot parse CCD sheet\n", name);
+        status = -1;
+    }
+
+    if (stream != NULL)
+    {
+        ccd_free (&ccd);
+        fclose (stream);
+    }
+
+    return status;
+}
+
+/**
+ * Write the fingerprint index of CCD sheets.
+ *
+ * \param[in] index  Fingerprint index file name;
+ * \param[in] count  Number of CCD sheets;
+ * \param[in] names  CCD sheet file names;
+ *
+ * \return Exit status: EX_OK if every sheet was indexed, or else
+ *         EX_DATAERR.
+ *
+ * Sheets that cannot be parsed are reported on standard error and
+ * left out of the index.
+ */
+
+static int build_index (const char *index, int count, char *const names[])
+{
+    struct fingerprint *entries;    /* Index entries; */
+    size_t entries_count = 0;       /* Number of index entries; */
+    FILE *stream;       /* Index stream; */
+    int status = EX_OK; /* Exit status; */
+    int i;              /* CCD sheet index; */
+
+    entries = xmalloc (sizeof (*entries) * (count + 1));
+    for (i = 0; i < count; i++)
+    {
+        if (read_fingerprint (names[i], &entries[entries_count].fingerprint) < 0)
+            status = EX_DATAERR;
+        else
+            entries[entries_count++].name = names[i];
+    }
+
+    stream = fopen (index, "wb");
+    if (stream == NULL)
+        error_pop_lib (fopen, EX_CANTCREAT, "cannot create '%s'", index);
+
+    fingerprint2stream (entries, entries_count, stream);
+
+    if (fclose (stream) == EOF)
+        exit(EX_IOERR);
+
+    printf ("Index: %s (%lu sheets)\n", index, (unsigned long) entries_count);
+    free (entries);
+
+    return status;
+}
+
+/**
+ * Look up CCD sheets in a fingerprint index.
+ *
+ * \param[in] index  Fingerprint index file name;
+ * \param[in] count  Number of CCD sheets;
+ * \param[in] names  CCD sheet file names;
+ *
+ * \return Exit status: EX_OK if every sheet was looked up, or else
+ *         EX_DATAERR.
+ *
+ * For each sheet, a line with its fingerprint in hexadecimal and its
+ * name, separated by a tab, is followed by the names of the indexed
+ * sheets sharing its layout, a line each.
+ */
+
+static int query_index (const char *index, int count, char *const names[])
+{
+    FILE *stream;       /* Index stream; */
+    int status = EX_OK; /* Exit status; */
+    int i;              /* CCD sheet index; */
+
+    stream = fopen (index, "rb");
+    if (stream == NULL)
+        error_pop_lib (fopen, EX_NOINPUT, "cannot open '%s'", index);
+
+    for (i = 0; i < count; i++)
+    {
+        uint64_t fingerprint;   /* Fingerprint of this sheet; */
+
+        if (read_fingerprint (names[i], &fingerprint) < 0)
+        {
+            status = EX_DATAERR;
+            continue;
+        }
+
+        printf ("%016llx\t%s\n", (unsigned long long) fingerprint, names[i]);
+        if (fingerprint_query (stream, fingerprint, stdout) < 0)
+            error_pop (EX_DATAERR, "cannot search '%s'", index);
+    }
+
+    if (fclose (stream) == EOF)
+        exit(EX_IOERR);
+
+    return status;
+}
+
 
 /**
  * Main entry point;
@@ -216,6 +841,8 @@ int main (int argc, char *argv[])
     struct ccd ccd;   /* CCD structure filled by stream2ccd; */
     struct cue *cue;  /* Pointer to CUE structure filled by ccd2cue; */
     struct cdt cdt;   /* CDT structure filled by ccd2cdt; */
+    struct sub sub = {NULL, 0};   /* Subchannel structure filled by
+                                     stream2sub; */
 
     /* TRANSLATORS: This is the Unix manual page 'NAME' description. */
     //_("CCD sheet to CUE sheet converter");
@@ -232,28 +859,207 @@ int main (int argc, char *argv[])
 //  assert (argp_retval == 0);
 
     memset(&arguments, 0, sizeof(arguments));
+    arguments.ccd_names = xmalloc (sizeof (*arguments.ccd_names) * argc);
     int i = 1;
     while (i < argc)
     {
         char *v = argv[i];
-        if (strcmp("--input", v) == 0 && i + 1 < argv)
+        if (strcmp("--input", v) == 0 && i + 1 < argc)
         {
             arguments.ccd_name = argv[++i];
         }
-        else if (strcmp("--output", v) == 0 && i + 1 < argv)
+        else if (strcmp("--output", v) == 0 && i + 1 < argc)
         {
             arguments.cue_name = argv[++i];
         }
-        else if (strcmp("--image", v) == 0 && i + 1 < argv)
+        else if (strcmp("--image", v) == 0 && i + 1 < argc)
         {
             arguments.img_name = argv[++i];
         }
+        else if (strcmp("--sub", v) == 0 && i + 1 < argc)
+        {
+            arguments.sub_name = argv[++i];
+        }
+        else if (strcmp("--write-sub", v) == 0 && i + 1 < argc)
+        {
+            arguments.write_sub_name = argv[++i];
+        }
+        else if (strcmp("--split", v) == 0)
+        {
+            arguments.split_flag = 1;
+        }
+        else if (strcmp("--swap", v) == 0)
+        {
+            arguments.swap_flag = 1;
+        }
+        else if (strcmp("--wave", v) == 0)
+        {
+            /* Audio tracks are written to files of their own. */
+            arguments.wave_flag = 1;
+            arguments.split_flag = 1;
+        }
+        else if (strcmp("--cdg", v) == 0)
+        {
+            arguments.cdg_flag = 1;
+        }
+        else if (strcmp("--probe", v) == 0)
+        {
+            arguments.probe_flag = 1;
+        }
+        else if (strcmp("--gaps", v) == 0)
+        {
+            arguments.gaps_flag = 1;
+        }
+        else if (strcmp("--accurip", v) == 0)
+        {
+            arguments.accurip_flag = 1;
+        }
+        else if (strcmp("--cdtext", v) == 0)
+        {
+            arguments.cdtext_flag = 1;
+        }
+        else if (strcmp("--lenient", v) == 0)
+        {
+            arguments.lenient_flag = 1;
+        }
+        else if (strcmp("--format", v) == 0 && i + 1 < argc)
+        {
+            arguments.format_name = argv[++i];
+        }
+        else if (strcmp("--offset", v) == 0 && i + 1 < argc)
+        {
+            arguments.offset_arg = argv[++i];
+        }
+        else if (strcmp("--discid", v) == 0)
+        {
+            arguments.discid_flag = 1;
+        }
+        else if (strcmp("--check", v) == 0)
+        {
+            arguments.check_flag = 1;
+        }
+        else if (strcmp("--reverse", v) == 0)
+        {
+            arguments.reverse_flag = 1;
+        }
+        else if (strcmp("--check-cdt", v) == 0)
+        {
+            arguments.check_cdt_flag = 1;
+        }
+        else if (strcmp("--inspect-cdt", v) == 0)
+        {
+            arguments.inspect_cdt_flag = 1;
+        }
+        else if (strcmp("--repair", v) == 0 && i + 1 < argc)
+        {
+            arguments.repair_name = argv[++i];
+        }
+        else if (strcmp("--index-build", v) == 0 && i + 1 < argc)
+        {
+            arguments.build_name = argv[++i];
+        }
+        else if (strcmp("--index-query", v) == 0 && i + 1 < argc)
+        {
+            arguments.query_name = argv[++i];
+        }
+        else if (v[0] != '-')
+        {
+            arguments.ccd_names[arguments.ccd_count++] = v;
+        }
         i++;
     }
 
-    if (arguments.ccd_name == 0 || arguments.cue_name == 0 || arguments.img_name == 0)
+    /* An unknown repair is a usage error. */
+    if (arguments.repair_name != NULL && strcmp (arguments.repair_name, "fix") != 0
+        && strcmp (arguments.repair_name, "drop") != 0)
+        arguments.check_cdt_flag = 0;
+
+    /* Identify or index any number of discs from their CCD sheets
+       alone. */
+    if (arguments.discid_flag || arguments.check_flag || arguments.reverse_flag
+        || arguments.check_cdt_flag || arguments.inspect_cdt_flag
+        || arguments.build_name != NULL || arguments.query_name != NULL)
     {
-        printf("Usage: ccd2cue.exe --input file.ccd --output file.cue --image file.bin");
+        if (arguments.ccd_name != NULL)
+            arguments.ccd_names[arguments.ccd_count++] = (char *) arguments.ccd_name;
+
+        /* Without sheets on the command line, take their names from
+           standard input, a line each, as listed by 'find'. */
+        if (arguments.ccd_count == 0)
+        {
+            char *line;         /* Line read; a new one each time; */
+            size_t length;      /* Length of LINE; */
+            int allocated = 0;  /* Room in ccd_names; */
+
+            while (my_getline (&line, &length, stdin) != -1)
+            {
+                if (length > 0 && line[length - 1] == '\n')
+                    line[--length] = '\0';
+                if (length == 0)
+                {
+                    free (line);
+                    continue;
+                }
+                if (arguments.ccd_count == allocated)
+                {
+                    allocated = allocated ? allocated * 2 : 1024;
+                    arguments.ccd_names = xrealloc (arguments.ccd_names,
+                                                    sizeof (*arguments.ccd_names)
+                                                    * allocated);
+                }
+                arguments.ccd_names[arguments.ccd_count++] = line;
+            }
+            free (line);
+        }
+
+        if (arguments.inspect_cdt_flag)
+            return inspect_cdts (arguments.ccd_count, arguments.ccd_names);
+        if (arguments.check_cdt_flag)
+            return check_cdts (arguments.ccd_count, arguments.ccd_names,
+                               arguments.repair_name);
+        if (arguments.reverse_flag)
+            return reverse_cues (arguments.ccd_count, arguments.ccd_names);
+        if (arguments.check_flag)
+            return check_images (arguments.ccd_count, arguments.ccd_names,
+                                 arguments.ccd_count == 1
+                                 ? arguments.img_name : NULL);
+        if (arguments.build_name != NULL)
+            return build_index (arguments.build_name, arguments.ccd_count,
+                                arguments.ccd_names);
+        if (arguments.query_name != NULL)
+            return query_index (arguments.query_name, arguments.ccd_count,
+                                arguments.ccd_names);
+        return print_discids (arguments.ccd_count, arguments.ccd_names);
+    }
+
+    /* CD+G images need the subchannel data and have a single file,
+       and so do shifted images. */
+    if (arguments.offset_arg != NULL)
+    {
+        char *end;      /* End of the number; */
+
+        errno = 0;
+        arguments.offset = strtol (arguments.offset_arg, &end, 10);
+        if (errno != 0 || end == arguments.offset_arg || *end != '\0')
+            arguments.ccd_name = NULL;
+    }
+    if (arguments.ccd_name == 0 || arguments.cue_name == 0 || arguments.img_name == 0
+        || (arguments.format_name != NULL && strcmp (arguments.format_name, "cue") != 0
+            && strcmp (arguments.format_name, "toc") != 0)
+        || (arguments.repair_name != NULL && !arguments.check_cdt_flag)
+        || (arguments.cdg_flag && (arguments.sub_name == NULL
+                                   || arguments.split_flag || arguments.swap_flag))
+        || (arguments.offset_arg != NULL && (arguments.cdg_flag
+                                             || arguments.split_flag || arguments.swap_flag)))
+    {
+        printf("Usage: ccd2cue.exe --input file.ccd --output file.cue --image file.bin [--sub file.sub] [--write-sub file.sub] [--split] [--swap] [--wave] [--cdg] [--probe] [--gaps] [--accurip] [--offset samples] [--cdtext] [--format cue|toc] [--lenient]\n"
+               "       ccd2cue.exe --discid file.ccd...\n"
+               "       ccd2cue.exe --check [--image file.img] file.ccd...\n"
+               "       ccd2cue.exe --reverse file.cue...\n"
+               "       ccd2cue.exe --check-cdt [--repair fix|drop] file.cdt...\n"
+               "       ccd2cue.exe --inspect-cdt file.cdt...\n"
+               "       ccd2cue.exe --index-build index.idx file.ccd...\n"
+               "       ccd2cue.exe --index-query index.idx file.ccd...");
         exit(EX_NOINPUT);
     }
 
@@ -271,16 +1077,363 @@ int main (int argc, char *argv[])
     arguments.cue_stream = fopen(arguments.cue_name, "w");
 
     /* Parse the CCD sheet input into a CCD structure. */
-    if (stream2ccd (arguments.ccd_stream, &ccd) < 0)
+    if (stream2ccd (arguments.ccd_stream, &ccd, arguments.lenient_flag) < 0)
         error_pop (EX_DATAERR, "cannot parse CCD sheet stream from '%s'", arguments.ccd_name);
 
-    /* Convert the CCD structure into a CUE structure. */
+    /* Recover the track data from the Q subchannel, if any, rather
+       than trusting the CCD sheet. */
+    if (arguments.sub_name != NULL)
+    {
+        FILE *sub_stream;   /* Subchannel stream; */
+        int entries;        /* Number of entries recovered; */
+        int interleaved;    /* Whether the subchannel is raw; */
+
+        sub_stream = fopen (arguments.sub_name, "rb");
+        if (sub_stream == NULL)
+            error_pop_lib (fopen, EX_NOINPUT, "cannot open subchannel '%s'",
+                           arguments.sub_name);
+
+        interleaved = sub_interleaved (sub_stream);
+        if (interleaved < 0 || stream2sub (sub_stream, &sub, interleaved) < 0)
+            error_pop (EX_DATAERR, "cannot parse subchannel stream from '%s'",
+                       arguments.sub_name);
+
+        if (fclose (sub_stream) == EOF)
+            exit(EX_IOERR);
+
+        entries = sub2ccd (&sub, &ccd);
+        printf("Subchannel: %s (%d entries recovered)\n", arguments.sub_name,
+               entries);
+    }
+
+    /* Tell the mode of each track from its first sectors, rather than
+       trusting the CCD sheet. */
+    if (arguments.probe_flag)
+    {
+        FILE *img_stream;   /* Disc image stream; */
+
+        img_stream = fopen (arguments.img_name, "rb");
+        if (img_stream == NULL)
+            error_pop_lib (fopen, EX_NOINPUT, "cannot open disc image '%s'",
+                           arguments.img_name);
+
+        for (i = 1; i <= ccd.TrackEntries; i++)
+        {
+            int mode = image_probe (&ccd, img_stream, i);
+
+            if (mode < 0)
+                error_pop (EX_DATAERR, "cannot probe '%s'", arguments.img_name);
+
+            if (mode != ccd.TRACK[i].MODE)
+            {
+                printf("Track %02d: MODE %d corrected to MODE %d\n", i,
+                       ccd.TRACK[i].MODE, mode);
+                ccd.TRACK[i].MODE = mode;
+            }
+        }
+
+        if (fclose (img_stream) == EOF)
+            exit(EX_IOERR);
+    }
+
+    /* Find the gaps between audio tracks the CCD sheet lacks from the
+       digital silence before them. */
+    if (arguments.gaps_flag)
+    {
+        FILE *img_stream;   /* Disc image stream; */
 
-    cue = ccd2cue (&ccd, arguments.img_name, arguments.cdt_name);
+        img_stream = fopen (arguments.img_name, "rb");
+        if (img_stream == NULL)
+            error_pop_lib (fopen, EX_NOINPUT, "cannot open disc image '%s'",
+                           arguments.img_name);
+
+        for (i = 2; i <= ccd.TrackEntries; i++)
+        {
+            struct ccd_TRACK *TRACK = &ccd.TRACK[i];
+            int gap;        /* First sector of the gap; */
+
+            /* Only gaps between audio tracks are silent. */
+            if (TRACK->MODE != 0 || ccd.TRACK[i - 1].MODE != 0
+                || TRACK->IndexEntries < 2 || TRACK->INDEX[0] != -1)
+                continue;
+
+            gap = image_gap (&ccd, img_stream, i);
+            if (gap < 0)
+                error_pop (EX_DATAERR, "cannot scan '%s'", arguments.img_name);
+
+            if (gap < TRACK->INDEX[1])
+            {
+                printf("Track %02d: INDEX 00 at %d (%d sectors of silence)\n",
+                       i, gap, TRACK->INDEX[1] - gap);
+                TRACK->INDEX[0] = gap;
+            }
+        }
+
+        if (fclose (img_stream) == EOF)
+            exit(EX_IOERR);
+    }
+
+    /* Checksum the audio tracks, as they are in the disc image, into a
+       report alongside it. */
+    if (arguments.accurip_flag)
+    {
+        FILE *img_stream;   /* Disc image stream; */
+        FILE *rep_stream;   /* Report stream; */
+        struct accurip *sums;   /* Checksums indexed by track number; */
+        char *rep_name = concat (arguments.reference_name, ".accurip", NULL);
+
+        if (rep_name == NULL)
+            error_pop (EX_OSERR, "cannot deduce report file name");
+
+        img_stream = fopen (arguments.img_name, "rb");
+        if (img_stream == NULL)
+            error_pop_lib (fopen, EX_NOINPUT, "cannot open disc image '%s'",
+                           arguments.img_name);
+
+        sums = xmalloc (sizeof (*sums) * (ccd.TrackEntries + 1));
+        for (i = 1; i <= ccd.TrackEntries; i++)
+            if (ccd.TRACK[i].MODE == 0
+                && accurip_track (&ccd, img_stream, i, &sums[i]) < 0)
+                error_pop (EX_DATAERR, "cannot checksum '%s'", arguments.img_name);
+
+        if (fclose (img_stream) == EOF)
+            exit(EX_IOERR);
+
+        rep_stream = fopen (rep_name, "w");
+        if (rep_stream == NULL)
+            error_pop_lib (fopen, EX_CANTCREAT, "cannot create '%s'", rep_name);
+
+        accurip2stream (&ccd, sums, rep_stream);
+
+        if (fclose (rep_stream) == EOF)
+            exit(EX_IOERR);
+
+        printf("Checksums: %s\n", rep_name);
+        free (sums);
+        free (rep_name);
+    }
+
+    /* Synthesize the subchannel data from the track data, sector by
+       sector up to the end of the disc image, or else up to the
+       lead-out. */
+    if (arguments.write_sub_name != NULL)
+    {
+        FILE *sub_stream;   /* Subchannel stream; */
+        FILE *img_stream;   /* Disc image stream; */
+        struct sub gen;     /* Subchannel structure filled by ccd2sub; */
+        off_t sectors;      /* Number of sectors to synthesize; */
+
+        img_stream = fopen (arguments.img_name, "rb");
+        if (img_stream != NULL)
+        {
+            sectors = image_size (img_stream);
+            if (sectors > 0)
+                sectors /= IMAGE_SECTOR_SIZE;
+            if (fclose (img_stream) == EOF)
+                exit(EX_IOERR);
+        }
+        else
+            sectors = ccd_leadout (&ccd);
+
+        if (sectors < 0)
+            error_pop (EX_DATAERR, "cannot tell the size of '%s'",
+                       arguments.img_name);
+
+        if (ccd2sub (&ccd, sectors, &gen) < 0)
+            error_pop (EX_DATAERR, "cannot generate subchannel data for '%s'",
+                       arguments.ccd_name);
+
+        sub_stream = fopen (arguments.write_sub_name, "wb");
+        if (sub_stream == NULL)
+            error_pop_lib (fopen, EX_CANTCREAT, "cannot create '%s'",
+                           arguments.write_sub_name);
+
+        sub2stream (&gen, sub_stream);
+
+        if (fclose (sub_stream) == EOF)
+            exit(EX_IOERR);
+
+        printf("Subchannel: %s (%ld sectors generated)\n",
+               arguments.write_sub_name, (long) sectors);
+        free (gen.sector);
+    }
+
+    /* Convert the CCD structure into a CUE structure.  When splitting,
+       carve each track out of the disc image into a file of its own
+       and reference those files instead.  When swapping, do the same
+       with a copy of the disc image whose audio samples are byte
+       swapped. */
+    if (arguments.cdg_flag)
+    {
+        FILE *img_stream;   /* Disc image stream; */
+        FILE *cdg_stream;   /* CD+G image stream; */
+        char *cdg_name = concat (arguments.reference_name, " (CD+G).bin", NULL);
+        size_t packs = 0;   /* CD+G packs found in the whole disc; */
+
+        if (cdg_name == NULL)
+            error_pop (EX_OSERR, "cannot deduce CD+G image file name");
+
+        /* Every sector of a CD+G image is 2448 bytes long, which
+           only audio tracks can be referenced with. */
+        for (i = 1; i <= ccd.TrackEntries; i++)
+        {
+            size_t n;       /* CD+G packs found in this track; */
+            int start = image_track_start (&ccd, i);
+            int end = i < ccd.TrackEntries
+                ? image_track_start (&ccd, i + 1) : (int) sub.sectors;
+
+            if (ccd.TRACK[i].MODE != 0)
+                error_pop (EX_DATAERR, "track %d is not an audio track", i);
+
+            n = start < 0 || end < start ? 0 : sub_cdg_packs (&sub, start, end);
+            printf("Track %02d: %lu CD+G packs\n", i, (unsigned long) n);
+            packs += n;
+        }
+
+        if (packs == 0)
+            error_pop (EX_DATAERR, "no CD+G data in '%s'", arguments.sub_name);
+
+        img_stream = fopen (arguments.img_name, "rb");
+        if (img_stream == NULL)
+            error_pop_lib (fopen, EX_NOINPUT, "cannot open disc image '%s'",
+                           arguments.img_name);
+
+        cdg_stream = fopen (cdg_name, "wb");
+        if (cdg_stream == NULL)
+            error_pop_lib (fopen, EX_CANTCREAT, "cannot create '%s'", cdg_name);
+
+        if (image_cdg (img_stream, &sub, cdg_stream) < 0)
+            error_pop (EX_IOERR, "cannot merge '%s' and '%s'",
+                       arguments.img_name, arguments.sub_name);
+
+        if (fclose (cdg_stream) == EOF || fclose (img_stream) == EOF)
+            exit(EX_IOERR);
+
+        /* Reference the merged image, whose tracks are all CD+G. */
+        cue = ccd2cue (&ccd, cdg_name, arguments.cdt_name);
+        if (cue != NULL)
+            for (i = cue->FILE[0].FirstTrack; i <= cue->FILE[0].TrackEntries; i++)
+                cue->FILE[0].TRACK[i].datatype = CDG_2448;
+    }
+    else if (arguments.offset_arg != NULL)
+    {
+        FILE *img_stream;   /* Disc image stream; */
+        FILE *off_stream;   /* Shifted disc image stream; */
+        char *off_name;     /* Shifted disc image file name; */
+        char suffix[32];    /* Suffix of the file name; */
+
+        snprintf (suffix, sizeof (suffix), " (Offset %+ld).img", arguments.offset);
+        off_name = concat (arguments.reference_name, suffix, NULL);
+        if (off_name == NULL)
+            error_pop (EX_OSERR, "cannot deduce shifted image file name");
+
+        img_stream = fopen (arguments.img_name, "rb");
+        if (img_stream == NULL)
+            error_pop_lib (fopen, EX_NOINPUT, "cannot open disc image '%s'",
+                           arguments.img_name);
+
+        off_stream = fopen (off_name, "wb");
+        if (off_stream == NULL)
+            error_pop_lib (fopen, EX_CANTCREAT, "cannot create '%s'", off_name);
+
+        if (image_offset (&ccd, img_stream, off_stream, arguments.offset) < 0)
+            error_pop (EX_IOERR, "cannot shift '%s'", arguments.img_name);
+
+        if (fclose (off_stream) == EOF || fclose (img_stream) == EOF)
+            exit(EX_IOERR);
+
+        /* The layout is the same, only the file differs. */
+        cue = ccd2cue (&ccd, off_name, arguments.cdt_name);
+    }
+    else if (arguments.split_flag || arguments.swap_flag)
+    {
+        FILE *img_stream;   /* Disc image stream; */
+
+        img_stream = fopen (arguments.img_name, "rb");
+        if (img_stream == NULL)
+            error_pop_lib (fopen, EX_NOINPUT, "cannot open disc image '%s'",
+                           arguments.img_name);
+
+        if (arguments.split_flag)
+        {
+            char **track_names; /* Track file names indexed by track
+                                   number; */
+            enum cue_filetype *track_types; /* Track file types indexed
+                                               by track number; */
+
+            track_names = xmalloc (sizeof (*track_names) * (ccd.TrackEntries + 1));
+            track_types = xmalloc (sizeof (*track_types) * (ccd.TrackEntries + 1));
+            for (i = 1; i <= ccd.TrackEntries; i++)
+            {
+                /* Audio tracks go to WAVE files when asked to; any
+                   other track to a binary file. */
+                if (arguments.wave_flag && ccd.TRACK[i].MODE == 0)
+                    track_types[i] = WAVE;
+                else if (arguments.swap_flag)
+                    track_types[i] = MOTOROLA;
+                else
+                    track_types[i] = BINARY;
+
+                track_names[i] = make_track_name (arguments.reference_name, i,
+                                                  track_types[i] == WAVE
+                                                  ? ".wav" : ".bin");
+                if (track_names[i] == NULL)
+                    error_pop (EX_OSERR, "cannot deduce track file name");
+            }
+
+            if (image_split (&ccd, img_stream, track_names, track_types) < 0)
+                error_pop (EX_IOERR, "cannot split '%s'", arguments.img_name);
+
+            cue = ccd2cue_split (&ccd, track_names, track_types,
+                                 arguments.cdt_name);
+        }
+        else
+        {
+            FILE *swp_stream;   /* Swapped disc image stream; */
+            char *swp_name = concat (arguments.reference_name, " (Swapped).img", NULL);
+
+            if (swp_name == NULL)
+                error_pop (EX_OSERR, "cannot deduce swapped image file name");
+
+            swp_stream = fopen (swp_name, "wb");
+            if (swp_stream == NULL)
+                error_pop_lib (fopen, EX_CANTCREAT, "cannot create '%s'", swp_name);
+
+            if (image_swap (&ccd, img_stream, swp_stream) < 0)
+                error_pop (EX_IOERR, "cannot swap '%s'", arguments.img_name);
+
+            if (fclose (swp_stream) == EOF)
+                exit(EX_IOERR);
+
+            /* The audio samples of the swapped copy are big endian. */
+            cue = ccd2cue (&ccd, swp_name, arguments.cdt_name);
+            if (cue != NULL)
+                cue->FILE[0].filetype = MOTOROLA;
+        }
+
+        if (fclose (img_stream) == EOF)
+            exit(EX_IOERR);
+    }
+    else
+        cue = ccd2cue (&ccd, arguments.img_name, arguments.cdt_name);
     if (cue == NULL)
         error_pop (EX_SOFTWARE, "cannot convert '%s' to '%s'",
                    arguments.ccd_name, arguments.cue_name);
 
+    /* The subchannel data is no longer needed. */
+    free (sub.sector);
+
+    /* Decode the CD-Text data into the CUE structure, as TOC files
+       carry it inline. */
+    if (arguments.cdtext_flag
+        || (arguments.format_name != NULL && strcmp (arguments.format_name, "toc") == 0))
+    {
+        int entries;        /* Number of CD-Text entries decoded; */
+
+        entries = ccd_CDText2cue (&ccd, 0, cue);
+        printf("CD-Text: %d entries decoded\n", entries);
+    }
+
     /* Convert the CD-Text data in the CCD structure into a CDT
        structure.  */
     if (ccd2cdt (&ccd, &cdt) > 0)
@@ -293,8 +1446,15 @@ int main (int argc, char *argv[])
             exit(EX_IOERR);
     }
 
-    /* Convert the CUE structure into the CUE sheet output. */
-    if (cue2stream (cue, arguments.cue_stream) < 0)
+    /* Convert the CUE structure into the CUE sheet output, or into a
+       cdrdao TOC file when asked to. */
+    if (arguments.format_name != NULL && strcmp (arguments.format_name, "toc") == 0)
+    {
+        if (toc2stream (cue, &ccd, arguments.cue_stream) < 0)
+            error_pop (EX_DATAERR, "cannot convert '%s' to '%s'",
+                       arguments.ccd_name, arguments.cue_name);
+    }
+    else if (cue2stream (cue, arguments.cue_stream) < 0)
         error_pop (EX_SOFTWARE, "cannot convert '%s' to '%s'",
                    arguments.ccd_name, arguments.cue_name);
 
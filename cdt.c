@@ -25,9 +25,21 @@
 
 #include "config.h"
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <assert.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "memory.h"
 #include "io.h"
+#include "errors.h"
+#include "array.h"
+#include "crc.h"
 #include "cdt.h"
 
 
@@ -46,3 +58,350 @@ cdt2stream (const struct cdt *cdt, FILE *stream)
   /* Put the terminating NULL character. */
   xputc (0, stream);
 }
+
+int
+cdt2file (const struct cdt *cdt, const char *name)
+{
+  char *temp_name;		/* Temporary file name; */
+  FILE *stream;			/* Temporary file stream; */
+  int error;			/* Reason of a failure; */
+  int replaced;			/* Whether NAME was replaced; */
+
+  /* Assert the CDT structure is valid. */
+  assert (cdt != NULL);
+
+  /* Assert the name is valid. */
+  assert (name != NULL);
+
+  temp_name = concat (name, ".tmp", NULL);
+  stream = fopen (temp_name, "wb");
+  if (stream == NULL)
+    {
+      free (temp_name);
+      error_push_lib (fopen, -1, "cannot create temporary file for '%s'",
+		      name);
+    }
+
+  /* Write the entries and the terminating NULL character, as
+     ::cdt2stream does, but without exiting on errors. */
+  if ((cdt->entries > 0
+       && fwrite (cdt->entry, sizeof (*cdt->entry), cdt->entries, stream)
+       < cdt->entries)
+      || putc (0, stream) == EOF)
+    {
+      error = errno;
+      fclose (stream);
+      remove (temp_name);
+      free (temp_name);
+      errno = error;
+      error_push_lib (fwrite, -1, "cannot write temporary file for '%s'",
+		      name);
+    }
+
+  if (fclose (stream) == EOF)
+    {
+      error = errno;
+      remove (temp_name);
+      free (temp_name);
+      errno = error;
+      error_push_lib (fclose, -1, "cannot write temporary file for '%s'",
+		      name);
+    }
+
+#ifdef _WIN32
+  /* Renaming over an existing file fails with the C library here. */
+  replaced = MoveFileExA (temp_name, name, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  replaced = rename (temp_name, name) == 0;
+#endif
+
+  if (!replaced)
+    {
+      error = errno;
+      remove (temp_name);
+      free (temp_name);
+      errno = error;
+      error_push_lib (rename, -1, "cannot replace '%s'", name);
+    }
+
+  free (temp_name);
+
+  /* Return success. */
+  return 0;
+}
+
+int
+stream2cdt (FILE *stream, struct cdt *cdt)
+{
+  uint8_t *buffer = NULL;	/* Stream contents; */
+  size_t length = 0;		/* Bytes read into BUFFER; */
+  size_t allocated = 0;		/* Bytes allocated in BUFFER; */
+  size_t rest;			/* Bytes past the last whole entry; */
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  /* Assert the CDT structure is valid. */
+  assert (cdt != NULL);
+
+  /* Initialize the CDT structure. */
+  cdt->entry = NULL;
+  cdt->entries = 0;
+
+  /* Read the whole stream. */
+  for (;;)
+    {
+      size_t count;		/* Bytes read; */
+
+      /* Make room for one more chunk, growing geometrically. */
+      if (allocated - length < CDT_BUFFER_SIZE)
+	{
+	  allocated = allocated ? allocated * 2 : CDT_BUFFER_SIZE;
+	  buffer = xrealloc (buffer, allocated);
+	}
+
+      count = fread (buffer + length, 1, CDT_BUFFER_SIZE, stream);
+      length += count;
+
+      /* Stop at the end of the stream. */
+      if (count < CDT_BUFFER_SIZE) break;
+    }
+
+  if (ferror (stream))
+    {
+      free (buffer);
+      error_push_lib (fread, -1, "cannot parse CDT stream");
+    }
+
+  /* Only the terminating null character may follow the entries. */
+  rest = length % sizeof (*cdt->entry);
+  if (rest > 1 || (rest == 1 && buffer[length - 1] != 0))
+    {
+      free (buffer);
+      error_push (-1, "truncated CDT entry at byte %lu",
+		  (unsigned long) (length - rest));
+    }
+
+  cdt->entry = (struct cdt_entry *) buffer;
+  cdt->entries = length / sizeof (*cdt->entry);
+
+  /* Return success. */
+  return 0;
+}
+
+size_t
+cdt_check (const struct cdt *cdt, uint16_t *crc)
+{
+  size_t bad = 0;		/* Entries whose CRC does not match; */
+  size_t i;			/* Entry index; */
+
+  /* Assert the CDT structure is valid. */
+  assert (cdt != NULL);
+
+  /* Assert the CRC array is valid. */
+  assert (crc != NULL);
+
+  if (cdt->entries == 0) return 0;
+
+  crc16_many (&cdt->entry[0].data, sizeof (cdt->entry[0].data),
+	      sizeof (cdt->entry[0]), cdt->entries, crc);
+
+  for (i = 0; i < cdt->entries; i++)
+    bad += (cdt->entry[i].crc[0] << 8 | cdt->entry[i].crc[1]) != crc[i];
+
+  return bad;
+}
+
+size_t
+cdt_repair (struct cdt *cdt, const uint16_t *crc, int drop_flag)
+{
+  size_t repaired = 0;		/* Entries fixed or dropped; */
+  size_t i, j;			/* Source and destination entry
+				   indexes; */
+
+  /* Assert the CDT structure is valid. */
+  assert (cdt != NULL);
+
+  /* Assert the CRC array is valid. */
+  assert (crc != NULL);
+
+  for (i = j = 0; i < cdt->entries; i++)
+    {
+      struct cdt_entry *entry = &cdt->entry[i]; /* Entry; */
+
+      if ((entry->crc[0] << 8 | entry->crc[1]) != crc[i])
+	{
+	  repaired++;
+	  if (drop_flag) continue;
+	  entry->crc[0] = (crc[i] >> 8) & 0xff;
+	  entry->crc[1] = crc[i] & 0xff;
+	}
+
+      if (i != j) cdt->entry[j] = *entry;
+      j++;
+    }
+
+  cdt->entries = j;
+
+  return repaired;
+}
+
+char *
+cdt_text (const struct cdt *cdt, int type, int block, int *first,
+	  size_t *length)
+{
+  char *text;			/* Text of TYPE; */
+  size_t i;			/* Entry index; */
+
+  /* Assert the CDT structure is valid. */
+  assert (cdt != NULL);
+
+  /* Assert the first track pointer is valid. */
+  assert (first != NULL);
+
+  /* Assert the length pointer is valid. */
+  assert (length != NULL);
+
+  /* Room for all entries, in case they are all of TYPE. */
+  text = xmalloc (sizeof (cdt->entry[0].data.text) * cdt->entries + 1);
+  *first = -1;
+  *length = 0;
+
+  for (i = 0; i < cdt->entries; i++)
+    {
+      const struct cdt_data *data = &cdt->entry[i].data; /* Entry data; */
+
+      if (data->type != type || ((data->block >> 4) & 0x07) != block
+	  || (data->block & 0x80))
+	continue;
+
+      if (*first < 0) *first = data->track;
+      memcpy (text + *length, data->text, sizeof (data->text));
+      *length += sizeof (data->text);
+    }
+
+  text[*length] = '\0';
+
+  return text;
+}
+
+/**
+ * Write a JSON string.
+ *
+ * \param[in]   string  String, in ISO 8859-1;
+ * \param[out]  stream  Output stream;
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ */
+
+static void
+cdt_json_string (const char *string, FILE *stream)
+{
+  const unsigned char *p;	/* Current character; */
+
+  xputc ('"', stream);
+  for (p = (const unsigned char *) string; *p != '\0'; p++)
+    if (*p == '"' || *p == '\\')
+      xfprintf (stream, "\\%c", *p);
+    else if (*p < 0x20 || *p > 0x7e)
+      xfprintf (stream, "\\u%04x", *p);
+    else
+      xputc (*p, stream);
+  xputc ('"', stream);
+}
+
+int
+cdt_inspect (FILE *input, const char *name, FILE *stream)
+{
+  static const char *const member[] =
+    {
+      [CDT_TITLE - CDT_TITLE] "title",
+      [CDT_PERFORMER - CDT_TITLE] "performer",
+      [CDT_SONGWRITER - CDT_TITLE] "songwriter",
+      [CDT_COMPOSER - CDT_TITLE] "composer",
+      [CDT_ARRANGER - CDT_TITLE] "arranger",
+      [CDT_MESSAGE - CDT_TITLE] "message",
+    };				/* JSON member of each text type; */
+  struct cdt cdt;		/* CDT structure filled by stream2cdt; */
+  uint16_t *crc;		/* Calculated CRCs; */
+  size_t bad;			/* Entries whose CRC does not match; */
+  size_t i, k;			/* Entry and type indexes; */
+
+  /* Assert the input stream is valid. */
+  assert (input != NULL);
+
+  /* Assert the output stream is valid. */
+  assert (stream != NULL);
+
+  /* Assert the name is valid. */
+  assert (name != NULL);
+
+  xfprintf (stream, "{\"file\":");
+  cdt_json_string (name, stream);
+
+  if (stream2cdt (input, &cdt) < 0)
+    {
+      xfprintf (stream, ",\"status\":\"invalid\"}\n");
+      return -1;
+    }
+
+  crc = xmalloc (sizeof (*crc) * (cdt.entries + 1));
+  bad = cdt_check (&cdt, crc);
+
+  xfprintf (stream, ",\"status\":\"%s\",\"entries\":%lu,\"bad\":[",
+	    bad == 0 ? "ok" : "bad", (unsigned long) cdt.entries);
+  for (i = 0, k = 0; k < bad; i++)
+    if ((cdt.entry[i].crc[0] << 8 | cdt.entry[i].crc[1]) != crc[i])
+      xfprintf (stream, k++ ? ",%lu" : "%lu", (unsigned long) i);
+  xputc (']', stream);
+
+  /* Split the text of each type into a string per track. */
+  for (k = 0; k < sizeof (member) / sizeof (member[0]); k++)
+    {
+      const char *previous = ""; /* String of the previous track; */
+      size_t length;		/* Length of TEXT; */
+      size_t p = 0;		/* Offset of the current string; */
+      int first;		/* Track of the first string; */
+      int track;		/* Track of the current string; */
+      int strings = 0;		/* Strings written; */
+      char *text = cdt_text (&cdt, CDT_TITLE + k, 0, &first, &length);
+
+      xfprintf (stream, ",\"%s\":{", member[k]);
+      for (track = first; first >= 0 && p < length && track <= 99; track++)
+	{
+	  const char *string = text + p; /* Current string; */
+
+	  p += strlen (string) + 1;
+	  if (strcmp (string, "\t") == 0) string = previous;
+	  previous = string;
+
+	  /* Padding after the last track makes up empty strings. */
+	  if (string[0] == '\0') continue;
+
+	  xfprintf (stream, strings++ ? ",\"%d\":" : "\"%d\":", track);
+	  cdt_json_string (string, stream);
+	}
+      xputc ('}', stream);
+
+      free (text);
+    }
+
+  xfprintf (stream, "}\n");
+
+  free (crc);
+  cdt_free (&cdt);
+
+  return bad;
+}
+
+void
+cdt_free (struct cdt *cdt)
+{
+  /* Assert the CDT structure is valid. */
+  assert (cdt != NULL);
+
+  free (cdt->entry);
+  cdt->entry = NULL;
+  cdt->entries = 0;
+}
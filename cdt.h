@@ -26,9 +26,16 @@
 #ifndef CCD2CUE_CDT_H
 #define CCD2CUE_CDT_H
 
+#include <stdio.h>
 #include <stddef.h>
 #include <stdint.h>
 
+/**
+ * Number of bytes ::stream2cdt reads at once.
+ */
+
+#define CDT_BUFFER_SIZE (18 * 4096)
+
 /**
  * _CD-Text_ entry type
  *
@@ -159,4 +166,175 @@ struct cdt
 void cdt2stream (const struct cdt *cdt, FILE *stream)
   __attribute__ ((nonnull));
 
+/**
+ * Replace a _CDT file_ with a _CDT structure_.
+ *
+ * \param[in]  cdt   Pointer to the _CDT structure_;
+ * \param[in]  name  _CDT file_ name;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * The stream of ::cdt2stream is written to NAME with ".tmp" appended,
+ * which is then renamed over NAME.  So NAME is left untouched on any
+ * failure, and the temporary file is removed.
+ *
+ * \sa ::cdt_repair
+ *
+ */
+
+int cdt2file (const struct cdt *cdt, const char *name)
+  __attribute__ ((nonnull));
+
+/**
+ * Parse a _CDT file_ stream into a _CDT structure_.
+ *
+ * \param[in]   stream  Input stream;
+ * \param[out]  cdt     Uninitialized _CDT structure_ to fill out;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * This is the inverse of ::cdt2stream.  The stream is read
+ * ::CDT_BUFFER_SIZE bytes at a time straight into the array of
+ * entries, as the stream and the structure have the same layout.  A
+ * single trailing null character is accepted; any other bytes past
+ * the last whole entry are an error.  CRCs are left as they are
+ * found, to be checked by ::cdt_check.
+ *
+ * The _CDT structure_ must be freed by ::cdt_free.
+ *
+ */
+
+int stream2cdt (FILE *stream, struct cdt *cdt)
+  __attribute__ ((nonnull));
+
+/**
+ * Check the CRCs of the entries of a _CDT structure_.
+ *
+ * \param[in]   cdt  _CDT structure_;
+ * \param[out]  crc  Array of CDT->entries CRCs, as they should be;
+ *
+ * \return The number of entries whose CRC does not match.
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * The CRCs are calculated in bulk by ::crc16_many and compared with
+ * the ones stored, most significant byte first.  Zeroed CRCs, as some
+ * rippers write, do not match either.
+ *
+ */
+
+size_t cdt_check (const struct cdt *cdt, uint16_t *crc)
+  __attribute__ ((nonnull));
+
+/**
+ * Repair the entries of a _CDT structure_ whose CRC does not match.
+ *
+ * \param[in,out]  cdt        _CDT structure_;
+ * \param[in]      crc        CRCs calculated by ::cdt_check;
+ * \param[in]      drop_flag  Whether to drop the entries rather than
+ *                            fixing their CRC;
+ *
+ * \return The number of entries fixed or dropped.
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * Fixing trusts the data of an entry and stores the CRC it should
+ * have.  Dropping removes the entry, keeping the others in order,
+ * for when the data is not to be trusted either.
+ *
+ */
+
+size_t cdt_repair (struct cdt *cdt, const uint16_t *crc, int drop_flag)
+  __attribute__ ((nonnull));
+
+/**
+ * Gather the text of a type of the entries of a _CDT structure_.
+ *
+ * \param[in]   cdt     _CDT structure_;
+ * \param[in]   type    Entry type, from ::CDT_TITLE to
+ *                      ::CDT_MESSAGE;
+ * \param[in]   block   _CD-Text_ block, that is language, from 0 to
+ *                      7;
+ * \param[out]  first   Track of the first entry of TYPE, or -1 if
+ *                      there is none;
+ * \param[out]  length  Length of the text;
+ *
+ * \return A newly allocated, null terminated, copy of the text.
+ *
+ * \since 0.3
+ *
+ * The 12 text bytes of the entries of TYPE in BLOCK are put one after
+ * another, in entry order, in a single pass.  The result is a null
+ * separated string per track, starting at FIRST, where a string made
+ * of a single TAB stands for the same text as the previous track.
+ * Entries of double byte character code blocks are skipped.
+ *
+ */
+
+char *cdt_text (const struct cdt *cdt, int type, int block, int *first,
+		size_t *length)
+  __attribute__ ((nonnull, malloc));
+
+/**
+ * Inspect a _CDT file_ stream and report on it in JSON.
+ *
+ * \param[in]   input   _CDT file_ stream;
+ * \param[in]   name    _CDT file_ name;
+ * \param[out]  stream  Output stream;
+ *
+ * \return The number of entries whose CRC does not match, or -1 if
+ *         INPUT is not a valid _CDT file_.
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ * \since 0.3
+ *
+ * INPUT is parsed by ::stream2cdt and checked by ::cdt_check.  A
+ * single line holding a JSON object is written to STREAM, with the
+ * members:
+ *
+ *- _file_: NAME;
+ *- _status_: _ok_, _bad_ or _invalid_;
+ *- _entries_: number of entries;
+ *- _bad_: array of the indexes of the entries whose CRC does not
+ *  match;
+ *- _title_, _performer_, _songwriter_, _composer_, _arranger_ and
+ *  _message_: objects mapping track numbers to the text of block 0,
+ *  as gathered by ::cdt_text;
+ *
+ * Text is taken as ISO 8859-1, so each byte above 0x7F is written as
+ * the Unicode escape of the same code point.
+ *
+ */
+
+int cdt_inspect (FILE *input, const char *name, FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Free a _CDT structure_ made by ::stream2cdt.
+ *
+ * \param[in]  cdt  _CDT structure_;
+ *
+ * \since 0.3
+ *
+ * A _CDT structure_ made by ::ccd2cdt shares the entries of its _CCD
+ * structure_ and must not be freed by this function.
+ *
+ */
+
+void cdt_free (struct cdt *cdt)
+  __attribute__ ((nonnull));
+
 #endif	/* CCD2CUE_CDT_H */
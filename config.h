@@ -2,6 +2,7 @@
 #define __CONFIG_H__
 
 #define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
 
 #include <corecrt.h>
 #include <stdio.h>
@@ -42,6 +42,7 @@
 #include "cue.h"
 #include "cdt.h"
 #include "crc.h"
+#include "image.h"
 #include "convert.h"
 
 
@@ -71,6 +72,103 @@ static void frames2msf (int frames, struct cue_time *msf)
   __attribute__ ((nonnull));
 
 
+/**
+ * Convert a _CCD_ track structure to a _CUE_ track structure.
+ *
+ * \param[in]   TRACK   _CCD_ track structure;
+ * \param[in]   origin  Frame where the track's file begins;
+ * \param[out]  track   Initialized _CUE_ track structure;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * This function fills out the data type, _FLAGS_, _ISRC_ and _INDEX_
+ * entries of a single track.  The _INDEX_ entries are made relative
+ * to ORIGIN, so a track can be referenced either from the whole disc
+ * image, with ORIGIN being 0, or from a file of its own.
+ *
+ * Mode 2 tracks of CD-i discs, as told by CDI_FLAG, are of data type
+ * _CDI/2352_ rather than _MODE2/2352_.  An unknown track mode is an
+ * error.
+ *
+ */
+
+static int ccd_TRACK2cue_TRACK (const struct ccd_TRACK *TRACK, int origin,
+				int cdi_flag, struct cue_TRACK *track)
+  __attribute__ ((nonnull));
+
+
+/**
+ * Convert a binary coded decimal byte to an integer.
+ *
+ * \param[in]  bcd  Binary coded decimal byte;
+ *
+ * \return The integer, or -1 if BCD is not a valid binary coded
+ *         decimal.
+ *
+ * \since 0.3
+ *
+ */
+
+static int bcd2int (uint8_t bcd)
+  __attribute__ ((const));
+
+/**
+ * Convert an integer to a binary coded decimal byte.
+ *
+ * \param[in]  n  Integer from 0 to 99;
+ *
+ * \return The binary coded decimal byte.
+ *
+ * \since 0.3
+ *
+ */
+
+static uint8_t int2bcd (int n)
+  __attribute__ ((const));
+
+
+/**
+ * Find the text entry of a _CUE structure_ for a track.
+ *
+ * \param[in]  cue    _CUE structure_;
+ * \param[in]  track  Track number, or 0 for the disc;
+ * \param[in]  type   ::CDT_TITLE, ::CDT_PERFORMER or
+ *                    ::CDT_SONGWRITER;
+ *
+ * \return A pointer to the entry, or NULL if there is no such track.
+ *
+ * \since 0.3
+ *
+ */
+
+static char **cue_text (struct cue *cue, int track, int type)
+  __attribute__ ((nonnull));
+
+/**
+ * Fill out a point of the TOC.
+ *
+ * \param[out]  Entry    _Entry_ section;
+ * \param[in]   Point    Point;
+ * \param[in]   Control  Control field;
+ * \param[in]   PLBA     Address, in frames from _INDEX 01_ of the
+ *                       first track;
+ *
+ * \since 0.3
+ *
+ * The MSF fields count the 2 seconds before the first track, as the
+ * TOC does.
+ *
+ */
+
+static void cue2ccd_Entry (struct ccd_Entry *Entry, unsigned int Point,
+			   unsigned int Control, int PLBA)
+  __attribute__ ((nonnull));
+
+
 /* Frame temporal definition */
 #define FRAMES_PER_SECOND 75 	/**< How many frames a second has; */
 #define SECONDS_PER_MINUTE 60	/**< How many seconds a minute has; */
@@ -95,6 +193,75 @@ frames2msf (int frames, struct cue_time *msf)
   msf->initialized = 1;
 }
 
+static int
+bcd2int (uint8_t bcd)
+{
+  /* Each nibble must be a decimal digit. */
+  if ((bcd >> 4) > 9 || (bcd & 0xf) > 9) return -1;
+
+  return (bcd >> 4) * 10 + (bcd & 0xf);
+}
+
+static uint8_t
+int2bcd (int n)
+{
+  /* Assert the integer fits in two decimal digits. */
+  assert(n >= 0 && n <= 99);
+
+  return ((n / 10) << 4) | (n % 10);
+}
+
+static int
+ccd_TRACK2cue_TRACK (const struct ccd_TRACK *TRACK, int origin,
+		     int cdi_flag, struct cue_TRACK *track)
+{
+  int j;			/* INDEX index; */
+
+  /* Assert the CCD track structure is valid. */
+  assert(TRACK != NULL);
+
+  /* Assert the CUE track structure is valid. */
+  assert(track != NULL);
+
+  /* Add datatype entry */
+  switch (TRACK->MODE)
+    {
+    case 0:		/* 0 means AUDIO */
+      track->datatype = AUDIO_2352;
+      break;
+    case 1:		/* 1 means MODE1/2352 */
+      track->datatype = MODE1_2352;
+      break;
+    case 2:		/* 2 means MODE2/2352, or CDI/2352 on CD-i */
+      track->datatype = cdi_flag ? CDI_2352 : MODE2_2352;
+      break;
+    default:		/* Anything else is unknown, but the disc
+			   image may still tell; see image_probe. */
+      error_push (-1, "unknown track mode %d", TRACK->MODE);
+    }
+
+  /* If there is a FLAGS entry for this track, add it. */
+  if (TRACK->FLAGS != NULL)
+    track->FLAGS = xstrdup (TRACK->FLAGS);
+
+  /* If there is ISRC entry for this track, add it. */
+  if (TRACK->ISRC[0] != '\0')
+    strncpy (track->ISRC, TRACK->ISRC, 12 + 1);
+
+  /* Allocate TRACK structure's INDEX array. */
+  track->INDEX = xmalloc (sizeof (*track->INDEX) * TRACK->IndexEntries);
+  track->IndexEntries = TRACK->IndexEntries;
+
+  /* Add each INDEX entry. */
+  for (j = 0; j < TRACK->IndexEntries; j++)
+    if (TRACK->INDEX[j] != -1)
+      frames2msf (TRACK->INDEX[j] - origin, &track->INDEX[j]);
+    else track->INDEX[j].initialized = 0;
+
+  /* Return success. */
+  return 0;
+}
+
 struct cue *
 ccd2cue (const struct ccd *ccd, const char *img_name, const char *cdt_name)
 {
@@ -128,7 +295,7 @@ ccd2cue (const struct ccd *ccd, const char *img_name, const char *cdt_name)
   /* If there is any TRACK section, process it. */
   if (ccd->TrackEntries > 0)
     {
-      size_t i;			/* TRACK index; */
+      int i;			/* TRACK index; */
 
       /* Allocate the CUE structure's TRACK array.  */
       cue->FILE[0].TrackEntries = ccd->TrackEntries;
@@ -137,56 +304,80 @@ ccd2cue (const struct ccd *ccd, const char *img_name, const char *cdt_name)
 
       /* Add each TRACK section. */
       for (i = cue->FILE[0].FirstTrack; i <= ccd->TrackEntries; i++)
-	{
-	  size_t j;		/* INDEX index; */
+	if (ccd_TRACK2cue_TRACK (&ccd->TRACK[i], 0,
+				 ccd_disc_type (ccd) == CCD_DISC_CDI,
+				 &cue->FILE[0].TRACK[i]) < 0)
+	  error_push (NULL, "cannot convert track %d", i);
+    }
 
-	  /* Add datatype entry */
-	  switch (ccd->TRACK[i].MODE)
-	    {
-	    case 0:		/* 0 means AUDIO */
-	      cue->FILE[0].TRACK[i].datatype = AUDIO_2352;
-	      break;
-	    case 1:		/* 1 means MODE1/2352 */
-	      cue->FILE[0].TRACK[i].datatype = MODE1_2352;
-	      break;
-	    case 2:		/* 2 means MODE2/2352 */
-	      cue->FILE[0].TRACK[i].datatype = MODE2_2352;
-	      break;
-	    default:		/* If you got here, the program
-				   certainly has a bug. */
-	      //error (1, 0, _("unknown track data type %d; please report a bug"),
-		   //  ccd->TRACK[i].MODE);
-          exit(EX_UNAVAILABLE);
-	    }
+  /* Return success. */
+  return cue;
+}
 
-	  /* If there is a FLAGS entry for this track, add it. */
-	  if (ccd->TRACK[i].FLAGS != NULL)
-	    cue->FILE[0].TRACK[i].FLAGS = xstrdup (ccd->TRACK[i].FLAGS);
+struct cue *
+ccd2cue_split (const struct ccd *ccd, char *const *file_names,
+	       const enum cue_filetype *file_types, const char *cdt_name)
+{
+  struct cue *cue;		/* Pointer to the resulting CUE structure. */
+  int i;			/* TRACK index; */
 
-	  /* If there is ISRC entry for this track, add it. */
-	  if (ccd->TRACK[i].ISRC[0] != '\0')
-	    strncpy (cue->FILE[0].TRACK[i].ISRC, ccd->TRACK[i].ISRC, 12 + 1);
+  /* Assert the CCD structure is valid. */
+  assert(ccd != NULL);
 
-	  /* Allocate TRACK structure's INDEX array. */
-	  cue->FILE[0].TRACK[i].INDEX = xmalloc (sizeof (*cue->FILE[0].TRACK[i].INDEX)
-					 * ccd->TRACK[i].IndexEntries);
-	  cue->FILE[0].TRACK[i].IndexEntries = ccd->TRACK[i].IndexEntries;
+  /* Assert the file names array is valid. */
+  assert(file_names != NULL);
 
-	  /* Add each INDEX entry. */
-	  for (j = 0; j < ccd->TRACK[i].IndexEntries; j++)
-	    if (ccd->TRACK[i].INDEX[j] != -1)
-	      frames2msf (ccd->TRACK[i].INDEX[j], &cue->FILE[0].TRACK[i].INDEX[j]);
-	    else cue->FILE[0].TRACK[i].INDEX[j].initialized = 0;
-	}
+  /* Assert the file types array is valid. */
+  assert(file_types != NULL);
+
+  /* Assert the CDT file name is valid. */
+  assert(cdt_name != NULL);
 
+  /* Initialize the CUE structure. */
+  cue = cue_init (1);
+
+  /* If there is MCN add a CATALOG entry.  */
+  if (ccd->Disc.CATALOG[0] != '\0') strncpy (cue->CATALOG, ccd->Disc.CATALOG, 13 + 1);
+
+  /* If there is CDText data add a CDTEXTFILE entry. */
+  if (ccd->CDText.Entries != 0)
+    cue->CDTEXTFILE = xstrdup (cdt_name);
+
+  /* Add one FILE entry per TRACK section. */
+  cue->FileEntries = ccd->TrackEntries;
+  cue->FILE = cue_FILE_init (cue->FileEntries);
+
+  for (i = 1; i <= ccd->TrackEntries; i++)
+    {
+      struct cue_FILE *file = &cue->FILE[i - 1]; /* This track's FILE
+						    entry; */
+
+      file->filename = xstrdup (file_names[i]);
+      file->filetype = file_types[i];
+
+      /* Each FILE entry holds only its own track, so the TRACK array
+	 is indexed by the track number as usual. */
+      file->FirstTrack = i;
+      file->TrackEntries = i;
+      file->TRACK = cue_TRACK_init (i + 1);
+
+      /* Add the TRACK section with INDEX entries relative to the
+	 beginning of its own file. */
+      if (ccd_TRACK2cue_TRACK (&ccd->TRACK[i], image_track_start (ccd, i),
+			       ccd_disc_type (ccd) == CCD_DISC_CDI,
+			       &file->TRACK[i]) < 0)
+	error_push (NULL, "cannot convert track %d", i);
     }
 
   /* Return success. */
   return cue;
 }
 
+/** Number of CDT entries whose CRCs ::ccd2cdt calculates at once; */
+#define CCD2CDT_BATCH 256
+
 int
-ccd2cdt (const struct ccd *ccd, struct cdt *cdt)
+ccd2cdt (struct ccd *ccd, struct cdt *cdt)
 {
   size_t i;			/* CDT entry index; */
 
@@ -196,24 +387,641 @@ ccd2cdt (const struct ccd *ccd, struct cdt *cdt)
   /* Assert the CDT structure is valid. */
   assert(cdt != NULL);
 
-  /* Allocate the CDT structure's entries. */
+  /* The CCD structure already holds the entries in the layout of a
+     CDT file, so just share them. */
   cdt->entries = ccd->CDText.Entries;
-  cdt->entry = xmalloc (sizeof (*cdt->entry) * cdt->entries);
+  cdt->entry = ccd->CDText.Entry;
 
-  /* Fill each CDT entry. */
-  for (i = 0; i < ccd->CDText.Entries; i++)
+  /* Fill the CRC of each CDT entry in place, a batch at a time. */
+  for (i = 0; i < cdt->entries; i += CCD2CDT_BATCH)
     {
-      uint16_t crc;		/* Negated CRC-16 (CCITT) */
+      uint16_t crc[CCD2CDT_BATCH]; /* Negated CRC-16 (CCITT) of
+				      each entry; */
+      size_t n = cdt->entries - i; /* Entries in this batch; */
+      size_t j;			   /* Batch index; */
+
+      if (n > CCD2CDT_BATCH) n = CCD2CDT_BATCH;
 
-      /* Copy the CDT data itself. */
-      memcpy (&cdt->entry[i].data, &ccd->CDText.Entry[i], sizeof (ccd->CDText.Entry[i]));
+      /* Calculate the negated CRC-16 (CCITT) of the whole batch. */
+      crc16_many (&cdt->entry[i].data, sizeof (cdt->entry[i].data),
+		  sizeof (cdt->entry[i]), n, crc);
 
-      /* Calculate the negated CRC-16 (CCITT). */
-      crc = crc16 (&cdt->entry[i].data, sizeof (cdt->entry[i].data));
-      cdt->entry[i].crc[0] = (crc >> 8) & 0xff;
-      cdt->entry[i].crc[1] = crc & 0xff;
+      for (j = 0; j < n; j++)
+	{
+	  cdt->entry[i + j].crc[0] = (crc[j] >> 8) & 0xff;
+	  cdt->entry[i + j].crc[1] = crc[j] & 0xff;
+	}
     }
 
   /* Return the number of CDT entries. */
   return cdt->entries;
 }
+
+/** Number of possible track numbers and index numbers; */
+#define SUB_NUMBERS 100
+
+/** Offset of the first sector of the disc image in frames; */
+#define LEAD_IN_FRAMES 150
+
+int
+ccd_CDText2cue (const struct ccd *ccd, int block, struct cue *cue)
+{
+  struct cdt cdt;		/* View of the CDText entries; */
+  int entries = 0;		/* Entries filled out; */
+  int k;			/* Type index; */
+
+  /* Assert the CCD structure is valid. */
+  assert(ccd != NULL);
+
+  /* Assert the CUE structure is valid. */
+  assert(cue != NULL);
+
+  if (ccd->CDText.Entries <= 0) return 0;
+
+  /* The CCD structure holds the entries in the layout of a CDT
+     file. */
+  cdt.entry = ccd->CDText.Entry;
+  cdt.entries = ccd->CDText.Entries;
+
+  /* Split the text of each type into a string per track. */
+  for (k = 0; k < 3; k++)
+    {
+      const char *previous = NULL; /* String of the previous track; */
+      size_t length;		/* Length of TEXT; */
+      size_t p = 0;		/* Offset of the current string; */
+      int first;		/* Track of the first string; */
+      int track;		/* Track of the current string; */
+      char *text = cdt_text (&cdt, CDT_TITLE + k, block, &first, &length);
+
+      for (track = first; first >= 0 && p < length && track <= 99; track++)
+	{
+	  const char *string = text + p; /* Current string; */
+	  char **field;		/* Entry to fill out; */
+
+	  p += strlen (string) + 1;
+	  if (strcmp (string, "\t") == 0) string = previous;
+	  previous = string;
+
+	  /* Padding after the last track makes up empty strings. */
+	  if (string == NULL || string[0] == '\0') continue;
+
+	  field = cue_text (cue, track, CDT_TITLE + k);
+	  if (field != NULL && *field == NULL)
+	    {
+	      *field = xstrdup (string);
+	      entries++;
+	    }
+	}
+
+      free (text);
+    }
+
+  /* Return the number of entries filled out. */
+  return entries;
+}
+
+int
+sub2ccd (const struct sub *sub, struct ccd *ccd)
+{
+  int *start;			/* First sector of each index of each
+				   track, as SUB_NUMBERS x SUB_NUMBERS
+				   matrix, or -1; */
+  int track = 0;		/* Track being played; */
+  int changes = 0;		/* Entries filled out or corrected; */
+  size_t i;			/* Sector index; */
+  int t, x;			/* Track and index numbers; */
+
+  /* Assert the subchannel structure is valid. */
+  assert(sub != NULL);
+
+  /* Assert the CCD structure is valid. */
+  assert(ccd != NULL);
+
+  start = xmalloc (sizeof (*start) * SUB_NUMBERS * SUB_NUMBERS);
+  for (i = 0; i < SUB_NUMBERS * SUB_NUMBERS; i++) start[i] = -1;
+
+  /* Scan the Q subchannel of every sector in a single pass. */
+  for (i = 0; i < sub->sectors; i++)
+    {
+      const uint8_t *q = sub->sector[i].channel[SUB_Q]; /* Q subchannel; */
+
+      /* Disregard damaged frames. */
+      if (! sub_q_check (&sub->sector[i])) continue;
+
+      switch (q[0] & 0x0f)
+	{
+	case SUB_Q_POSITION:
+	  {
+	    int rm = bcd2int (q[3]), rs = bcd2int (q[4]), rf = bcd2int (q[5]);
+	    int am = bcd2int (q[7]), as = bcd2int (q[8]), af = bcd2int (q[9]);
+	    int frames;		/* Sector of this frame; */
+
+	    t = bcd2int (q[1]);
+	    x = bcd2int (q[2]);
+
+	    /* Disregard the lead-out and anything not decimal. */
+	    if (t < 1 || x < 0 || rm < 0 || rs < 0 || rf < 0
+		|| am < 0 || as < 0 || af < 0)
+	      break;
+	    track = t;
+
+	    /* The absolute time of the frame tells its sector. */
+	    frames = am * FRAMES_PER_MINUTE + as * FRAMES_PER_SECOND + af
+	      - LEAD_IN_FRAMES;
+
+	    /* From INDEX 01 on, the relative time counts up from the
+	       beginning of INDEX 01.  So any such frame tells exactly
+	       where INDEX 01 is, even if the first frames there carry
+	       MCN or ISRC data instead of the position. */
+	    if (x >= 1 && start[t * SUB_NUMBERS + 1] == -1)
+	      start[t * SUB_NUMBERS + 1] =
+		frames - (rm * FRAMES_PER_MINUTE + rs * FRAMES_PER_SECOND + rf);
+
+	    /* Any other index begins on its first frame seen. */
+	    if (x != 1 && start[t * SUB_NUMBERS + x] == -1)
+	      start[t * SUB_NUMBERS + x] = frames;
+	    break;
+	  }
+	case SUB_Q_MCN:
+	  {
+	    char CATALOG[13 + 1];	/* Media Catalog Number; */
+	    int d;			/* Digit index; */
+
+	    /* The 13 digits are packed as nibbles, most significant
+	       first. */
+	    for (d = 0; d < 13; d++)
+	      {
+		int digit = (q[1 + d / 2] >> (d % 2 ? 0 : 4)) & 0xf;
+		if (digit > 9) break;
+		CATALOG[d] = '0' + digit;
+	      }
+	    CATALOG[13] = '\0';
+
+	    /* An all zero MCN means there is none. */
+	    if (d < 13 || strcmp (CATALOG, "0000000000000") == 0) break;
+
+	    if (strcmp (ccd->Disc.CATALOG, CATALOG) != 0)
+	      {
+		if (ccd->Disc.CATALOG[0] != '\0')
+		  fprintf (stderr, "CATALOG: '%s' corrected to '%s'\n",
+			   ccd->Disc.CATALOG, CATALOG);
+		strcpy (ccd->Disc.CATALOG, CATALOG);
+		changes++;
+	      }
+	    break;
+	  }
+	case SUB_Q_ISRC:
+	  {
+	    char ISRC[12 + 1];	/* International Standard Recording
+				   Code; */
+	    uint64_t bits = 0;	/* The first 8 data bytes; */
+	    int c;		/* Character index; */
+
+	    if (track < 1 || track > ccd->TrackEntries) break;
+
+	    for (c = 1; c <= 8; c++) bits = (bits << 8) | q[c];
+
+	    /* The first 5 characters are 6 bit codes: 0 to 9 for
+	       digits and 17 to 42 for letters. */
+	    for (c = 0; c < 5; c++)
+	      {
+		int code = (bits >> (58 - 6 * c)) & 0x3f;
+		if (code <= 9) ISRC[c] = '0' + code;
+		else if (code >= 17 && code <= 42) ISRC[c] = 'A' + code - 17;
+		else break;
+	      }
+	    if (c < 5) break;
+
+	    /* The remaining 7 are binary coded decimal digits,
+	       starting after 2 padding bits. */
+	    for (c = 0; c < 7; c++)
+	      {
+		int digit = (bits >> (28 - 4 * c)) & 0xf;
+		if (digit > 9) break;
+		ISRC[5 + c] = '0' + digit;
+	      }
+	    if (c < 7) break;
+	    ISRC[12] = '\0';
+
+	    if (strcmp (ccd->TRACK[track].ISRC, ISRC) != 0)
+	      {
+		if (ccd->TRACK[track].ISRC[0] != '\0')
+		  fprintf (stderr, "TRACK %d ISRC: '%s' corrected to '%s'\n",
+			   track, ccd->TRACK[track].ISRC, ISRC);
+		strcpy (ccd->TRACK[track].ISRC, ISRC);
+		changes++;
+	      }
+	    break;
+	  }
+	}
+    }
+
+  /* Fill out or correct the INDEX entries of each track. */
+  for (t = 1; t <= ccd->TrackEntries && t < SUB_NUMBERS; t++)
+    for (x = 0; x < SUB_NUMBERS; x++)
+      {
+	int frames = start[t * SUB_NUMBERS + x]; /* Sector of the index; */
+	struct ccd_TRACK *TRACK = &ccd->TRACK[t];
+
+	/* Disregard indexes not seen or outside the disc image. */
+	if (frames < 0) continue;
+
+	/* Make room for the index, leaving any gap unset. */
+	if (x >= TRACK->IndexEntries)
+	  {
+	    TRACK->INDEX = xrealloc (TRACK->INDEX, sizeof (*TRACK->INDEX) * (x + 1));
+	    while (TRACK->IndexEntries <= x)
+	      TRACK->INDEX[TRACK->IndexEntries++] = -1;
+	  }
+
+	if (TRACK->INDEX[x] != frames)
+	  {
+	    if (TRACK->INDEX[x] != -1)
+	      fprintf (stderr, "TRACK %d INDEX %d: %d corrected to %d\n",
+		       t, x, TRACK->INDEX[x], frames);
+	    TRACK->INDEX[x] = frames;
+	    changes++;
+	  }
+      }
+
+  free (start);
+
+  /* Return the number of entries filled out or corrected. */
+  return changes;
+}
+
+/** Sector of each group of SUB_NUMBERS sectors carrying the MCN; */
+#define SUB_MCN_SECTOR 50
+
+/** Sector of each group of SUB_NUMBERS sectors carrying the ISRC; */
+#define SUB_ISRC_SECTOR 75
+
+int
+ccd2sub (const struct ccd *ccd, size_t sectors, struct sub *sub)
+{
+  int track = 1;		/* Track of the current sector; */
+  int index = 0;		/* Index of the current sector; */
+  int next;			/* First sector of the next track; */
+  unsigned int control = 0;	/* Control field of the current track; */
+  size_t s;			/* Sector index; */
+  int i;			/* Entry index; */
+
+  /* Assert the CCD structure is valid. */
+  assert(ccd != NULL);
+
+  /* Assert the subchannel structure is valid. */
+  assert(sub != NULL);
+
+  /* There is nothing to position sectors against without tracks. */
+  if (ccd->TrackEntries < 1)
+    error_push (-1, "no track to generate subchannel data for");
+
+  /* Allocate the subchannel structure, whose R to W channels are left
+     empty. */
+  sub->sectors = sectors;
+  sub->sector = xmalloc (sizeof (*sub->sector) * (sectors ? sectors : 1));
+  memset (sub->sector, 0, sizeof (*sub->sector) * sectors);
+
+  next = ccd->TrackEntries > 1 ? image_track_start (ccd, 2) : -1;
+
+  /* Fill out every sector in a single pass, keeping track of where
+     the current track and index are. */
+  for (s = 0; s < sectors; s++)
+    {
+      const struct ccd_TRACK *TRACK; /* Current track; */
+      uint8_t *q = sub->sector[s].channel[SUB_Q]; /* Q subchannel; */
+      int index1;		/* First sector of INDEX 01; */
+      int first;		/* Whether S is the first sector of its
+				   index; */
+      int rel, abs;		/* Relative and absolute times; */
+      uint16_t crc;		/* Negated CRC-16 (CCITT); */
+
+      /* Move on to the next track, once it is reached. */
+      if (s == 0 || (next >= 0 && (int) s >= next))
+	{
+	  if (s > 0)
+	    {
+	      track++;
+	      next = track < ccd->TrackEntries
+		? image_track_start (ccd, track + 1) : -1;
+	    }
+	  index = 0;
+
+	  /* Take the control field from the TOC, or else guess it
+	     from the track mode. */
+	  control = ccd->TRACK[track].MODE == 0 ? 0x0 : 0x4;
+	  for (i = 0; i < ccd->Disc.TocEntries; i++)
+	    if (ccd->Entry[i].Point == (unsigned int) track)
+	      {
+		control = ccd->Entry[i].Control & 0xf;
+		break;
+	      }
+	}
+      TRACK = &ccd->TRACK[track];
+
+      /* Move on to the last index already reached. */
+      first = 0;
+      while (index + 1 < TRACK->IndexEntries
+	     && TRACK->INDEX[index + 1] != -1
+	     && (int) s >= TRACK->INDEX[index + 1])
+	{
+	  index++;
+	  first = (int) s == TRACK->INDEX[index];
+	}
+      if (s == 0 || (int) s == image_track_start (ccd, track)) first = 1;
+
+      /* The relative time counts down to INDEX 01 in the pre-gap and
+	 up from it elsewhere. */
+      index1 = TRACK->IndexEntries > 1 && TRACK->INDEX[1] != -1
+	? TRACK->INDEX[1] : image_track_start (ccd, track);
+      rel = (int) s < index1 ? index1 - (int) s : (int) s - index1;
+      abs = (int) s + LEAD_IN_FRAMES;
+
+      /* The P channel flags the pause of the pre-gap. */
+      if (index == 0 && (int) s < index1)
+	memset (sub->sector[s].channel[SUB_P], 0xff, SUB_CHANNEL_SIZE);
+
+      /* Every hundred sectors, a single sector carries the MCN and
+	 another one the ISRC of audio tracks instead of the position,
+	 but never the first sector of an index, which must be
+	 found. */
+      if (! first && s % SUB_NUMBERS == SUB_MCN_SECTOR
+	  && ccd->Disc.CATALOG[0] != '\0')
+	{
+	  int d;		/* Digit index; */
+
+	  q[0] = (control << 4) | SUB_Q_MCN;
+	  for (d = 0; d < 13 && ccd->Disc.CATALOG[d] != '\0'; d++)
+	    q[1 + d / 2] |= ((ccd->Disc.CATALOG[d] - '0') & 0xf) << (d % 2 ? 0 : 4);
+	  q[9] = int2bcd (abs % FRAMES_PER_SECOND);
+	}
+      else if (! first && s % SUB_NUMBERS == SUB_ISRC_SECTOR
+	       && TRACK->MODE == 0 && TRACK->ISRC[0] != '\0')
+	{
+	  uint64_t bits = 0;	/* The first 8 data bytes; */
+	  int c;		/* Character index; */
+
+	  /* The first 5 characters are 6 bit codes and the remaining
+	     7 binary coded decimal digits, after 2 padding bits. */
+	  for (c = 0; c < 5; c++)
+	    {
+	      int code = TRACK->ISRC[c] >= 'A'
+		? TRACK->ISRC[c] - 'A' + 17 : TRACK->ISRC[c] - '0';
+	      bits |= (uint64_t) (code & 0x3f) << (58 - 6 * c);
+	    }
+	  for (c = 0; c < 7; c++)
+	    bits |= (uint64_t) ((TRACK->ISRC[5 + c] - '0') & 0xf)
+	      << (28 - 4 * c);
+
+	  q[0] = (control << 4) | SUB_Q_ISRC;
+	  for (c = 1; c <= 8; c++)
+	    q[c] = (bits >> (64 - 8 * c)) & 0xff;
+	  q[9] = int2bcd (abs % FRAMES_PER_SECOND);
+	}
+      else
+	{
+	  q[0] = (control << 4) | SUB_Q_POSITION;
+	  q[1] = int2bcd (track);
+	  q[2] = int2bcd (index);
+	  q[3] = int2bcd (rel / FRAMES_PER_MINUTE % 100);
+	  q[4] = int2bcd (rel % FRAMES_PER_MINUTE / FRAMES_PER_SECOND);
+	  q[5] = int2bcd (rel % FRAMES_PER_SECOND);
+	  q[6] = 0;
+	  q[7] = int2bcd (abs / FRAMES_PER_MINUTE % 100);
+	  q[8] = int2bcd (abs % FRAMES_PER_MINUTE / FRAMES_PER_SECOND);
+	  q[9] = int2bcd (abs % FRAMES_PER_SECOND);
+	}
+
+      /* Seal the frame with its CRC, most significant byte first. */
+      crc = crc16 (q, SUB_CHANNEL_SIZE - 2);
+      q[SUB_CHANNEL_SIZE - 2] = (crc >> 8) & 0xff;
+      q[SUB_CHANNEL_SIZE - 1] = crc & 0xff;
+    }
+
+  /* Return success. */
+  return 0;
+}
+
+int
+cue2ccd (const struct cue *cue, const long *sectors, struct ccd *ccd)
+{
+  long origin = 0;		/* First sector of the current file; */
+  int tracks = 0;		/* Number of tracks; */
+  int disc_type = CCD_DISC_CDDA; /* Disc type for point 0xA0; */
+  unsigned int *control;	/* Control field indexed by track; */
+  int f;			/* FILE index; */
+  int i;			/* TRACK index; */
+
+  /* Assert the CUE structure is valid. */
+  assert(cue != NULL);
+
+  /* Assert the file sizes are valid. */
+  assert(sectors != NULL);
+
+  /* Assert the CCD structure is valid. */
+  assert(ccd != NULL);
+
+  /* Initialize the CCD structure. */
+  memset (ccd, 0, sizeof (*ccd));
+  ccd->CloneCD.Version = 3;
+  strncpy (ccd->Disc.CATALOG, cue->CATALOG, 13 + 1);
+
+  /* Count the tracks of every FILE entry first, so the TRACK
+     array is allocated once. */
+  for (f = 0; f < cue->FileEntries; f++)
+    if (cue->FILE[f].TRACK != NULL)
+      tracks += cue->FILE[f].TrackEntries - cue->FILE[f].FirstTrack + 1;
+  if (tracks == 0)
+    error_push (-1, "no tracks");
+
+  ccd->TRACK = xmalloc (sizeof (*ccd->TRACK) * (tracks + 1));
+  control = xmalloc (sizeof (*control) * (tracks + 1));
+
+  /* Add each TRACK section, with INDEX entries relative to the whole
+     disc image. */
+  for (f = 0; f < cue->FileEntries; f++)
+    {
+      const struct cue_FILE *file = &cue->FILE[f]; /* FILE entry; */
+      int t;			/* Track number; */
+
+      /* Audio in any other file type would need to be decoded or
+	 byte swapped into the disc image. */
+      if (file->filetype != BINARY)
+	{
+	  free (control);
+	  error_push (-1, "'%s' is not a BINARY file", file->filename);
+	}
+
+      for (t = file->FirstTrack; file->TRACK != NULL && t <= file->TrackEntries;
+	   t++)
+	{
+	  const struct cue_TRACK *track = &file->TRACK[t]; /* TRACK entry; */
+	  struct ccd_TRACK *TRACK = &ccd->TRACK[++ccd->TrackEntries];
+	  int j;		/* INDEX index; */
+
+	  TRACK->FLAGS = NULL;
+	  TRACK->INDEX = NULL;
+	  TRACK->IndexEntries = 0;
+
+	  if (t != ccd->TrackEntries)
+	    {
+	      free (control);
+	      error_push (-1, "track %d out of sequence", t);
+	    }
+
+	  switch (track->datatype)
+	    {
+	    case AUDIO_2352:
+	      TRACK->MODE = 0;
+	      control[t] = 0x00;
+	      break;
+	    case MODE1_2352:
+	      TRACK->MODE = 1;
+	      control[t] = 0x04;
+	      break;
+	    case MODE2_2352:
+	      TRACK->MODE = 2;
+	      control[t] = 0x04;
+	      if (disc_type == CCD_DISC_CDDA) disc_type = CCD_DISC_XA;
+	      break;
+	    case CDI_2352:
+	      TRACK->MODE = 2;
+	      control[t] = 0x04;
+	      disc_type = CCD_DISC_CDI;
+	      break;
+	    default:
+	      free (control);
+	      error_push (-1, "track %d is not of a raw data type", t);
+	    }
+
+	  if (track->PREGAP.initialized || track->POSTGAP.initialized)
+	    {
+	      free (control);
+	      error_push (-1, "track %d has a gap missing from its file", t);
+	    }
+
+	  /* Digital copy, four channels and pre-emphasis make up the
+	     rest of the control field. */
+	  if (track->FLAGS != NULL)
+	    {
+	      TRACK->FLAGS = xstrdup (track->FLAGS);
+	      if (strstr (track->FLAGS, "DCP") != NULL) control[t] |= 0x02;
+	      if (strstr (track->FLAGS, "4CH") != NULL) control[t] |= 0x08;
+	      if (strstr (track->FLAGS, "PRE") != NULL) control[t] |= 0x01;
+	    }
+
+	  strncpy (TRACK->ISRC, track->ISRC, 12 + 1);
+
+	  /* INDEX 00 and INDEX 01 are always there. */
+	  TRACK->IndexEntries = track->IndexEntries > 2 ? track->IndexEntries : 2;
+	  TRACK->INDEX = xmalloc (sizeof (*TRACK->INDEX) * TRACK->IndexEntries);
+	  for (j = 0; j < TRACK->IndexEntries; j++)
+	    {
+	      const struct cue_time *msf = &track->INDEX[j]; /* INDEX entry; */
+	      long frame;	/* INDEX entry in the file; */
+
+	      TRACK->INDEX[j] = -1;
+	      if (j >= track->IndexEntries || !msf->initialized) continue;
+
+	      frame = (msf->minutes * SECONDS_PER_MINUTE + msf->seconds)
+		* FRAMES_PER_SECOND + msf->frames;
+	      if (frame >= sectors[f])
+		{
+		  free (control);
+		  error_push (-1, "track %d: INDEX %02d beyond the end of '%s'",
+			      t, j, file->filename);
+		}
+
+	      TRACK->INDEX[j] = origin + frame;
+	    }
+
+	  if (TRACK->INDEX[1] == -1)
+	    {
+	      free (control);
+	      error_push (-1, "track %d has no INDEX 01", t);
+	    }
+	}
+
+      origin += sectors[f];
+    }
+
+  /* A single session, whose pre-gap is of the mode of the first
+     track. */
+  ccd->Disc.Sessions = 1;
+  ccd->Session = xmalloc (sizeof (*ccd->Session) * (ccd->Disc.Sessions + 1));
+  ccd->Session[1].PreGapMode = ccd->TRACK[1].MODE;
+  ccd->Session[1].PreGapSubC = 0;
+
+  /* Points 0xA0, 0xA1 and 0xA2, then one for each track. */
+  ccd->Disc.TocEntries = 3 + ccd->TrackEntries;
+  ccd->Entry = xmalloc (sizeof (*ccd->Entry) * (ccd->Disc.TocEntries + 1));
+
+  /* Points 0xA0 and 0xA1 tell the first and last track numbers as
+     minutes, and 0xA0 the disc type as seconds. */
+  cue2ccd_Entry (&ccd->Entry[0], 0xa0, control[1],
+		 FRAMES_PER_MINUTE + disc_type * FRAMES_PER_SECOND
+		 - 2 * FRAMES_PER_SECOND);
+  cue2ccd_Entry (&ccd->Entry[1], 0xa1, control[ccd->TrackEntries],
+		 ccd->TrackEntries * FRAMES_PER_MINUTE - 2 * FRAMES_PER_SECOND);
+
+  cue2ccd_Entry (&ccd->Entry[2], 0xa2, control[ccd->TrackEntries], origin);
+
+  for (i = 1; i <= ccd->TrackEntries; i++)
+    cue2ccd_Entry (&ccd->Entry[2 + i], i, control[i], ccd->TRACK[i].INDEX[1]);
+
+  free (control);
+
+  /* Return success. */
+  return 0;
+}
+
+static char **
+cue_text (struct cue *cue, int track, int type)
+{
+  struct cue_TRACK *TRACK = NULL; /* TRACK entry; */
+  int f;			/* FILE index; */
+
+  /* Assert the CUE structure is valid. */
+  assert(cue != NULL);
+
+  if (track == 0)
+    return type == CDT_TITLE ? &cue->TITLE
+      : type == CDT_PERFORMER ? &cue->PERFORMER : &cue->SONGWRITER;
+
+  for (f = 0; f < cue->FileEntries && TRACK == NULL; f++)
+    if (cue->FILE[f].TRACK != NULL && track >= cue->FILE[f].FirstTrack
+	&& track <= cue->FILE[f].TrackEntries)
+      TRACK = &cue->FILE[f].TRACK[track];
+
+  if (TRACK == NULL) return NULL;
+
+  return type == CDT_TITLE ? &TRACK->TITLE
+    : type == CDT_PERFORMER ? &TRACK->PERFORMER : &TRACK->SONGWRITER;
+}
+
+static void
+cue2ccd_Entry (struct ccd_Entry *Entry, unsigned int Point,
+	       unsigned int Control, int PLBA)
+{
+  struct cue_time msf;		/* PLBA counting the first 2 seconds; */
+
+  /* Assert the Entry section is valid. */
+  assert(Entry != NULL);
+
+  frames2msf (PLBA + 2 * FRAMES_PER_SECOND, &msf);
+
+  Entry->Session = 1;
+  Entry->Point = Point;
+  Entry->ADR = 0x01;
+  Entry->Control = Control;
+  Entry->TrackNo = 0;
+  Entry->AMin = 0;
+  Entry->ASec = 0;
+  Entry->AFrame = 0;
+  Entry->ALBA = -2 * FRAMES_PER_SECOND;
+  Entry->Zero = 0;
+  Entry->PMin = msf.minutes;
+  Entry->PSec = msf.seconds;
+  Entry->PFrame = msf.frames;
+  Entry->PLBA = PLBA;
+}
@@ -28,6 +28,7 @@
 
 #include "ccd.h"
 #include "cue.h"
+#include "sub.h"
 
 /**
  * Convert _CCD structure_ to _CUE structure_.
@@ -146,11 +147,51 @@
 struct cue * ccd2cue (const struct ccd *ccd, const char *img_name, const char *cdt_name)
   __attribute__ ((nonnull));
 
+/**
+ * Convert _CCD structure_ to _CUE structure_ with one file per track.
+ *
+ * \param[in]   ccd         _CCD structure_;
+ * \param[in]   file_names  Array of track file names indexed by track
+ *                          number; used in _FILE_ entries.
+ * \param[in]   file_types  Array of track file types indexed by track
+ *                          number; used in _FILE_ entries.
+ * \param[in]   cdt_name    CDT file name; used in _CDTEXTFILE_ entry.
+ *
+ * \return A pointer to the resulting _CUE structure_ or _NULL_ in
+ * case of a conversion error.
+ *
+ * \since 0.3
+ *
+ * This function does just like ::ccd2cue, except that instead of a
+ * single _FILE_ entry for the whole disc image, it generates one
+ * _FILE_ entry per track, each one holding only that track.  The
+ * _INDEX_ entries are relative to the beginning of the track's own
+ * file, that begins at its _INDEX 00_ entry, if any, or at its _INDEX
+ * 01_ entry otherwise.
+ *
+ * The track files themselves are produced by ::image_split.
+ *
+ * \sa
+ * - Previous step:
+ *   + ::stream2ccd
+ * - Parallel step:
+ *   + ::image_split
+ *   + ::ccd2cdt
+ * - Next step:
+ *   + ::cue2stream
+ *
+ */
+
+struct cue * ccd2cue_split (const struct ccd *ccd, char *const *file_names,
+			    const enum cue_filetype *file_types,
+			    const char *cdt_name)
+  __attribute__ ((nonnull));
+
 /**
  * Extract _CDText data_ from _CCD structure_.
  *
- * \param[in]   ccd  _CCD structure_;
- * \param[out]  cdt  _CDT structure_;
+ * \param[in,out]  ccd  _CCD structure_;
+ * \param[out]     cdt  _CDT structure_;
  *
  * \return  Number of _CDText entries_ in the resulting _CDT
  *          structure_;
@@ -172,6 +213,12 @@ struct cue * ccd2cue (const struct ccd *ccd, const char *img_name, const char *c
  * format to which the _CDT structure_ ought to be converted by
  * ::cdt2stream.
  *
+ * The _CCD structure_ keeps its _CDText data_ in the layout of a _CDT
+ * file_, so the CRCs are filled in place and the _CDT structure_
+ * shares the array of entries of CCD, instead of copying it.  The
+ * _CDT structure_ is thus valid as long as CCD is, and its entries
+ * are freed by ::ccd_free.
+ *
  * It is worth to emphasize that even when the input _CCD structure_
  * has no _CDText data_ a correct, and empty, _CDT structure_ is
  * generated and 0 is returned.
@@ -189,7 +236,177 @@ struct cue * ccd2cue (const struct ccd *ccd, const char *img_name, const char *c
  *
  */
 
-int ccd2cdt (const struct ccd *ccd, struct cdt *cdt)
+int ccd2cdt (struct ccd *ccd, struct cdt *cdt)
+  __attribute__ ((nonnull));
+
+/**
+ * Decode the _CD-Text_ data of a _CCD structure_ into a _CUE
+ * structure_.
+ *
+ * \param[in]      ccd    _CCD structure_;
+ * \param[in]      block  _CD-Text_ block, that is language, from 0
+ *                        to 7;
+ * \param[in,out]  cue    _CUE structure_ made from CCD;
+ *
+ * \return The number of entries filled out.
+ *
+ * \since 0.3
+ *
+ * The _TITLE_, _PERFORMER_ and _SONGWRITER_ entries, at global and
+ * track scope, are filled out from the packs of type ::CDT_TITLE,
+ * ::CDT_PERFORMER and ::CDT_SONGWRITER of BLOCK, as an alternative or
+ * a complement to the _CDTEXTFILE_ entry ::ccd2cdt stands for.
+ * Entries already filled out are left alone.
+ *
+ * The text of the packs of each type is gathered in a single pass
+ * over them, into a buffer allocated once, and then split at the
+ * null characters into one string per track, from the track of the
+ * first pack on, where track 0 stands for the disc.  A string made of
+ * a single tab stands for the same text as the previous track.
+ * Double byte blocks are not decoded.
+ *
+ * \sa
+ *- Previous step:
+ *  + ::ccd2cue
+ *  + ::ccd2cue_split
+ *- Next step:
+ *  + ::cue2stream
+ *  + ::toc2stream
+ *
+ */
+
+int ccd_CDText2cue (const struct ccd *ccd, int block, struct cue *cue)
+  __attribute__ ((nonnull));
+
+/**
+ * Recover track data from the Q subchannel into a _CCD structure_.
+ *
+ * \param[in]      sub  Subchannel structure;
+ * \param[in,out]  ccd  _CCD structure_;
+ *
+ * \return  Number of entries filled out or corrected in the _CCD
+ *          structure_;
+ *
+ * \since 0.3
+ *
+ * Some rippers get the _INDEX_ entries of the _TRACK_ sections wrong,
+ * or leave them out.  This function scans the Q subchannel of every
+ * sector whose CRC matches, as checked by ::sub_q_check, and takes
+ * what the disc itself says as the authoritative reference:
+ *
+ *- Position frames (ADR 1) give the first sector of each index of
+ *  each track, that fill out or correct the _INDEX_ entries,
+ *  including _INDEX 00_ for pre-gaps.  _INDEX 01_ is derived from
+ *  the relative time, so it is exact even when its first frames
+ *  carry MCN or ISRC data; other indexes begin on their first
+ *  position frame;
+ *- MCN frames (ADR 2) fill out or correct the _CATALOG_ entry;
+ *- ISRC frames (ADR 3) fill out or correct the _ISRC_ entry of the
+ *  track being played;
+ *
+ * Every correction of an entry already present in the _CCD
+ * structure_ is reported on standard error.
+ *
+ * The subchannel data is assumed to start at the first sector of the
+ * disc image, so the pre-gap of the first track, which is not part
+ * of the disc image, is never seen.  Every other gap is part of the
+ * disc image and thus it is expressed as an _INDEX 00_ entry rather
+ * than as a _PREGAP_ one.
+ *
+ * \sa
+ *- Previous step:
+ *  + ::stream2ccd
+ *  + ::stream2sub
+ *- Next step:
+ *  + ::ccd2cue
+ *
+ */
+
+int sub2ccd (const struct sub *sub, struct ccd *ccd)
+  __attribute__ ((nonnull));
+
+/**
+ * Convert a _CCD structure_ into a subchannel structure.
+ *
+ * \param[in]   ccd      _CCD structure_;
+ * \param[in]   sectors  Number of sectors of the disc image;
+ * \param[out]  sub      Uninitialized subchannel structure to fill
+ *                       out;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * This function synthesizes the subchannel data of a disc image
+ * whose ".sub" file is missing, from the _INDEX_ entries of its
+ * _TRACK_ sections, in a single pass over the sectors:
+ *
+ *- The P channel is set throughout the pre-gap of each track;
+ *- The Q channel carries position frames (ADR 1), with the control
+ *  field of the track as found in the TOC, or else as implied by its
+ *  mode.  Within every hundred sectors, sector 50 carries the MCN,
+ *  if there is a _CATALOG_ entry, and sector 75 the ISRC of audio
+ *  tracks with an _ISRC_ entry, unless it is the first sector of an
+ *  index.  Every frame is sealed with its ::crc16;
+ *- The R to W channels are left empty;
+ *
+ * The result reads back through ::sub2ccd into the same _INDEX_,
+ * _CATALOG_ and _ISRC_ entries.
+ *
+ * \sa
+ *- Previous step:
+ *  + ::stream2ccd
+ *- Next step:
+ *  + ::sub2stream
+ *
+ */
+
+int ccd2sub (const struct ccd *ccd, size_t sectors, struct sub *sub)
+  __attribute__ ((nonnull));
+
+/**
+ * Convert a _CUE structure_ into a _CCD structure_.
+ *
+ * \param[in]   cue      _CUE structure_ filled out by ::stream2cue;
+ * \param[in]   sectors  Number of sectors of each file of the FILE
+ *                       entries;
+ * \param[out]  ccd      Uninitialized _CCD structure_ to fill out;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * This is the reverse of ::ccd2cue.  The files of the FILE entries
+ * are taken as laid one after another in a single disc image, so the
+ * _INDEX_ entries of the _TRACK_ sections are made absolute by
+ * adding up the SECTORS of the files before them, and the lead-out
+ * comes right after the last file.
+ *
+ * A single session TOC is synthesized from them, as CloneCD lays it
+ * out: the _Entry_ sections for points 0xA0, 0xA1 and 0xA2, telling
+ * the first and last track numbers, the disc type and the lead-out,
+ * followed by one for each track, with both MSF and LBA fields.  The
+ * control field of each point comes from the track mode and its
+ * _FLAGS_ entry.
+ *
+ * Only _BINARY_ files of raw data types fit a CloneCD disc image,
+ * and pre-gaps and post-gaps the files lack cannot be made up, so
+ * anything else is an error.
+ * Tracks must be numbered from 1 on.  _CD-Text_ is not synthesized.
+ *
+ * \sa
+ *- Previous step:
+ *  + ::stream2cue
+ *- Next step:
+ *  + ::ccd2stream
+ *
+ */
+
+int cue2ccd (const struct cue *cue, const long *sectors, struct ccd *ccd)
   __attribute__ ((nonnull));
 
 #endif	/* CCD2CUE_CONVERT_H */
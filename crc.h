@@ -31,6 +31,13 @@
 
 /* Polynomials */
 #define P16CCITT_N 0x1021 	/**< CRC-16-CCITT Normal */
+#define P32_R 0xedb88320	/**< CRC-32 Reversed */
+
+/**
+ * Number of messages ::crc16_many processes at once.
+ */
+
+#define CRC16_LANES 4
 
 /**
  * Calculate a negated 16 bit Cyclic Redundancy Check using a normal
@@ -46,11 +53,11 @@
  * \since 0.2
  *
  * This function computes the negated 16 bit CRC using the polynomial
- * P16CCITT_N (0x1021).
+ * P16CCITT_N (0x1021), a byte at a time by means of a lookup table.
  *
  * This function is used to calculate the checksum for _CD-Text_
  * entries as required by the _CDT file_ format in the ::ccd2cdt
- * function.
+ * function, and for the Q subchannel of every sector.
  *
  * \sa cdt_entry.crc
  *
@@ -59,4 +66,60 @@
 uint16_t crc16 (const void *message, size_t length)
   __attribute__ ((nonnull, warn_unused_result, pure));
 
+/**
+ * Calculate the negated CRC-16-CCITT of many messages of the same
+ * length.
+ *
+ * \param[in]   messages  A pointer to the first message.
+ * \param[in]   length    The length of each message in bytes.
+ * \param[in]   stride    The distance between the beginning of
+ *                        consecutive messages in bytes.
+ * \param[in]   n         The number of messages.
+ * \param[out]  crc       Array of N CRCs, as ::crc16 returns them.
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * Messages as short as _CD-Text_ packs leave the table lookups of
+ * ::crc16 waiting on each other, as each step depends on the previous
+ * one.  This function runs ::CRC16_LANES independent messages in the
+ * same loop, so their lookups are in flight at once, and also saves a
+ * call per message.
+ *
+ * \sa ::ccd2cdt
+ *
+ */
+
+void crc16_many (const void *messages, size_t length, size_t stride,
+		 size_t n, uint16_t *crc)
+  __attribute__ ((nonnull));
+
+/**
+ * Calculate a 32 bit Cyclic Redundancy Check, as in ZIP and PNG.
+ *
+ * \param[in]  crc      CRC of the preceding data, or 0;
+ * \param[in]  message  A pointer to the message.
+ * \param[in]  length   The length of the message in bytes.
+ *
+ * \return Return the CRC-32 of the preceding data followed by the
+ *         message.
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * This function computes the 32 bit CRC using the reflected
+ * polynomial P32_R (0xEDB88320), a byte at a time by means of a
+ * lookup table.  A long message can be processed in pieces, passing
+ * the result for a piece as CRC for the next one.
+ *
+ * This function is used to calculate the CRC of audio tracks in the
+ * ::accurip2stream report.
+ *
+ */
+
+uint32_t crc32 (uint32_t crc, const void *message, size_t length)
+  __attribute__ ((nonnull, warn_unused_result, pure));
+
 #endif	/* CCD2CUE_CRC_H */
@@ -24,10 +24,15 @@
 
 
 #include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "memory.h"
 #include "io.h"
+#include "errors.h"
+#include "array.h"
 #include "cue.h"
 
 
@@ -70,6 +75,70 @@ static char *datatype[] =
     [CDI_2336] "CDI/2336",
     [CDI_2352] "CDI/2352" };
 
+
+/**
+ * Initialize a ::cue_FILE structure in place.
+ *
+ * \param[out]  file  _FILE entry_ structure;
+ *
+ * \since 0.3
+ *
+ * \sa ::cue_FILE_init
+ *
+ */
+
+static void cue_FILE_clear (struct cue_FILE *file)
+  __attribute__ ((nonnull));
+
+/**
+ * Initialize a ::cue_TRACK structure in place.
+ *
+ * \param[out]  track  _TRACK entry_ structure;
+ *
+ * \since 0.3
+ *
+ * \sa ::cue_TRACK_init
+ *
+ */
+
+static void cue_TRACK_clear (struct cue_TRACK *track)
+  __attribute__ ((nonnull));
+
+/**
+ * Split the next token off a _CUE sheet_ line.
+ *
+ * \param[in,out]  p  Pointer to the remainder of the line;
+ *
+ * \return The token, or NULL if there is none left.
+ *
+ * \since 0.3
+ *
+ * Tokens are separated by white space, unless double quoted.  The
+ * token is terminated in place and P is left past it, so a line is
+ * tokenized without any copy.
+ *
+ */
+
+static char *cue_token (char **p)
+  __attribute__ ((nonnull));
+
+/**
+ * Parse an _MSF time_ token.
+ *
+ * \param[in]   token  Token in the form "mm:ss:ff";
+ * \param[out]  msf    _MSF time_ structure;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ */
+
+static int cue_msf (const char *token, struct cue_time *msf)
+  __attribute__ ((nonnull));
+
 
 struct cue *
 cue_init (size_t entries)
@@ -109,13 +178,7 @@ cue_FILE_init (size_t entries)
 
   /* Initialize FILE structures. */
   for (entry = 0; entry < entries; entry++)
-    {
-      file[entry].filename = NULL;
-      file[entry].filetype = MOTOROLA;
-      file[entry].TRACK = NULL;
-      file[entry].TrackEntries = 0;
-      file[entry].FirstTrack = 1;
-    }
+    cue_FILE_clear (&file[entry]);
 
   /* Return the newly allocated array of FILE structures. */
   return file;
@@ -133,18 +196,7 @@ cue_TRACK_init (size_t entries)
 
   /* Initialize TRACK structures. */
   for (entry = 0; entry < entries; entry++)
-    {
-      track[entry].datatype = 0;
-      track[entry].FLAGS = NULL;
-      track[entry].ISRC[0] = '\0';
-      track[entry].PERFORMER = NULL;
-      track[entry].SONGWRITER = NULL;
-      track[entry].TITLE = NULL;
-      track[entry].PREGAP.initialized = 0;
-      track[entry].INDEX = NULL;
-      track[entry].IndexEntries = 0;
-      track[entry].POSTGAP.initialized = 0;
-    }
+    cue_TRACK_clear (&track[entry]);
 
   /* Return the newly allocated array of TRACK structures. */
   return track;
@@ -253,3 +305,311 @@ cue2stream (const struct cue *cue, FILE *stream)
   /* Return with success. */
   return 0;
 }
+
+int
+stream2cue (FILE *stream, struct cue *cue)
+{
+  struct cue_FILE *file = NULL;	/* Current FILE entry; */
+  struct cue_TRACK *track = NULL; /* Current TRACK entry; */
+  int line_number = 0;		/* Current line number; */
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  /* Assert the CUE structure is valid. */
+  assert (cue != NULL);
+
+  /* Parse the whole stream, a line at a time.  Only the first token
+     of a line is compared against the keywords, and their arguments
+     are tokenized in place. */
+  for (;;)
+    {
+      char *line = NULL;	/* Last line read from stream; */
+      size_t line_size = 0;	/* Length of LINE; */
+      char *p;			/* Remainder of LINE; */
+      char *keyword;		/* First token of LINE; */
+      char *arg;		/* Next token of LINE; */
+
+      if (my_getline (&line, &line_size, stream) == -1)
+	{
+	  free (line);
+	  if (ferror (stream))
+	    error_push_lib (getline, -1, "cannot parse CUE sheet stream");
+	  break;
+	}
+      line_number++;
+
+      p = line;
+      keyword = cue_token (&p);
+      arg = cue_token (&p);
+
+      if (keyword == NULL || strcmp (keyword, "REM") == 0)
+	;
+      else if (strcmp (keyword, "FILE") == 0)
+	{
+	  char *type = cue_token (&p); /* File type token; */
+	  int t;			/* File type; */
+
+	  if (arg == NULL || type == NULL)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: malformed FILE entry", line_number);
+	    }
+
+	  for (t = BINARY; t <= MP3; t++)
+	    if (strcmp (type, filetype[t]) == 0) break;
+	  if (t > MP3)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: unknown file type", line_number);
+	    }
+
+	  /* Add a FILE entry. */
+	  cue->FILE = xrealloc (cue->FILE, sizeof (*cue->FILE)
+				* (cue->FileEntries + 1));
+	  file = &cue->FILE[cue->FileEntries++];
+	  cue_FILE_clear (file);
+	  file->filename = xstrdup (arg);
+	  file->filetype = t;
+	  track = NULL;
+	}
+      else if (strcmp (keyword, "TRACK") == 0)
+	{
+	  char *type = cue_token (&p); /* Data type token; */
+	  int number;		/* Track number; */
+	  int t;			/* Data type; */
+
+	  if (file == NULL || arg == NULL || type == NULL
+	      || sscanf (arg, "%d", &number) != 1 || number < 1 || number > 99)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: malformed TRACK entry", line_number);
+	    }
+
+	  for (t = AUDIO_2352; t <= CDI_2352; t++)
+	    if (strcmp (type, datatype[t]) == 0) break;
+	  if (t > CDI_2352)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: unknown data type", line_number);
+	    }
+
+	  /* Tracks of a FILE entry must be sequential. */
+	  if (file->TRACK != NULL && number != file->TrackEntries + 1)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: track %d out of sequence",
+			  line_number, number);
+	    }
+	  if (file->TRACK == NULL)
+	    file->FirstTrack = number;
+
+	  /* The TRACK array is indexed by the track number. */
+	  file->TRACK = xrealloc (file->TRACK, sizeof (*file->TRACK)
+				  * (number + 1));
+	  file->TrackEntries = number;
+	  track = &file->TRACK[number];
+	  cue_TRACK_clear (track);
+	  track->datatype = t;
+	}
+      else if (strcmp (keyword, "INDEX") == 0)
+	{
+	  char *time = cue_token (&p); /* MSF token; */
+	  int number;		/* Index number; */
+
+	  if (track == NULL || arg == NULL || time == NULL
+	      || sscanf (arg, "%d", &number) != 1 || number < 0 || number > 99)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: malformed INDEX entry", line_number);
+	    }
+
+	  /* The INDEX array is indexed by the index number. */
+	  if (number >= track->IndexEntries)
+	    {
+	      track->INDEX = xrealloc (track->INDEX, sizeof (*track->INDEX)
+				       * (number + 1));
+	      for (; track->IndexEntries <= number; track->IndexEntries++)
+		track->INDEX[track->IndexEntries].initialized = 0;
+	    }
+
+	  if (cue_msf (time, &track->INDEX[number]) < 0)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: malformed INDEX time", line_number);
+	    }
+	}
+      else if (strcmp (keyword, "PREGAP") == 0
+	       || strcmp (keyword, "POSTGAP") == 0)
+	{
+	  if (track == NULL || arg == NULL
+	      || cue_msf (arg, keyword[1] == 'R'
+			  ? &track->PREGAP : &track->POSTGAP) < 0)
+	    {
+	      free (line);
+	      error_push (-1, "line %d: malformed %s entry", line_number,
+			  keyword);
+	    }
+	}
+      else if (strcmp (keyword, "FLAGS") == 0)
+	{
+	  if (track != NULL && arg != NULL)
+	    {
+	      /* Flags take the rest of the line. */
+	      size_t length = strcspn (p, "\r\n");
+
+	      while (length > 0 && (p[length - 1] == ' ' || p[length - 1] == '\t'))
+		length--;
+	      p[length] = '\0';
+	      free (track->FLAGS);
+	      track->FLAGS = *p != '\0' ? concat (arg, " ", p, NULL) : xstrdup (arg);
+	    }
+	}
+      else if (strcmp (keyword, "ISRC") == 0)
+	{
+	  if (track != NULL && arg != NULL)
+	    snprintf (track->ISRC, sizeof (track->ISRC), "%s", arg);
+	}
+      else if (strcmp (keyword, "CATALOG") == 0)
+	{
+	  if (arg != NULL)
+	    snprintf (cue->CATALOG, sizeof (cue->CATALOG), "%s", arg);
+	}
+      else if (strcmp (keyword, "CDTEXTFILE") == 0)
+	{
+	  if (arg != NULL)
+	    {
+	      free (cue->CDTEXTFILE);
+	      cue->CDTEXTFILE = xstrdup (arg);
+	    }
+	}
+      else if (strcmp (keyword, "PERFORMER") == 0
+	       || strcmp (keyword, "SONGWRITER") == 0
+	       || strcmp (keyword, "TITLE") == 0)
+	{
+	  /* Before the first TRACK entry these belong to the disc. */
+	  char **field = keyword[0] == 'P'
+	    ? (track ? &track->PERFORMER : &cue->PERFORMER)
+	    : keyword[0] == 'S'
+	    ? (track ? &track->SONGWRITER : &cue->SONGWRITER)
+	    : (track ? &track->TITLE : &cue->TITLE);
+
+	  if (arg != NULL)
+	    {
+	      free (*field);
+	      *field = xstrdup (arg);
+	    }
+	}
+
+      /* Anything else is not needed to reconstruct the disc, and is
+	 ignored. */
+      free (line);
+    }
+
+  /* Return success. */
+  return 0;
+}
+
+void
+cue_free (struct cue *cue)
+{
+  int i;			/* FILE index; */
+
+  /* Assert the CUE structure is valid. */
+  assert (cue != NULL);
+
+  for (i = 0; i < cue->FileEntries; i++)
+    {
+      struct cue_FILE *file = &cue->FILE[i]; /* FILE entry; */
+      int j;			/* TRACK number; */
+
+      for (j = file->FirstTrack; file->TRACK != NULL && j <= file->TrackEntries;
+	   j++)
+	{
+	  free (file->TRACK[j].FLAGS);
+	  free (file->TRACK[j].PERFORMER);
+	  free (file->TRACK[j].SONGWRITER);
+	  free (file->TRACK[j].TITLE);
+	  free (file->TRACK[j].INDEX);
+	}
+
+      free (file->TRACK);
+      free (file->filename);
+    }
+
+  free (cue->FILE);
+  free (cue->CDTEXTFILE);
+  free (cue->PERFORMER);
+  free (cue->SONGWRITER);
+  free (cue->TITLE);
+  free (cue);
+}
+
+static void
+cue_FILE_clear (struct cue_FILE *file)
+{
+  file->filename = NULL;
+  file->filetype = MOTOROLA;
+  file->TRACK = NULL;
+  file->TrackEntries = 0;
+  file->FirstTrack = 1;
+}
+
+static void
+cue_TRACK_clear (struct cue_TRACK *track)
+{
+  track->datatype = 0;
+  track->FLAGS = NULL;
+  track->ISRC[0] = '\0';
+  track->PERFORMER = NULL;
+  track->SONGWRITER = NULL;
+  track->TITLE = NULL;
+  track->PREGAP.initialized = 0;
+  track->INDEX = NULL;
+  track->IndexEntries = 0;
+  track->POSTGAP.initialized = 0;
+}
+
+static char *
+cue_token (char **p)
+{
+  char *token;			/* Token found; */
+
+  *p += strspn (*p, " \t\r\n");
+  if (**p == '\0') return NULL;
+
+  if (**p == '"')
+    {
+      /* A quoted token ends at the closing quote, or else at the end
+	 of the line. */
+      token = ++*p;
+      *p += strcspn (*p, "\"\r\n");
+    }
+  else
+    {
+      token = *p;
+      *p += strcspn (*p, " \t\r\n");
+    }
+
+  if (**p != '\0') *(*p)++ = '\0';
+
+  return token;
+}
+
+static int
+cue_msf (const char *token, struct cue_time *msf)
+{
+  unsigned int minutes, seconds, frames;
+  char end;			/* Detects trailing garbage; */
+
+  if (sscanf (token, "%u:%u:%u%c", &minutes, &seconds, &frames, &end) != 3
+      || seconds >= 60 || frames >= 75)
+    return -1;
+
+  msf->minutes = minutes;
+  msf->seconds = seconds;
+  msf->frames = frames;
+  msf->initialized = 1;
+
+  return 0;
+}
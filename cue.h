@@ -334,4 +334,55 @@ struct cue_TRACK * cue_TRACK_init (size_t entries);
 int cue2stream (const struct cue *cue, FILE *stream)
   __attribute__ ((nonnull));
 
+/**
+ * Parse _CUE sheet_ stream into a _CUE sheet_ structure.
+ *
+ * \param[in]   stream  Input stream;
+ * \param[out]  cue     Pointer to a ::cue structure initialized by
+ *                      ::cue_init to fill out;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * This is the inverse of ::cue2stream.  Every declaration it outputs
+ * is recognized; _REM_ and unknown declarations are ignored.  The
+ * TRACK array of each FILE entry is indexed by track number and the
+ * INDEX array of each track by index number, as ::cue2stream expects
+ * them.
+ *
+ * Lines are split into tokens in place and only their first token is
+ * compared against the keywords, so parsing costs a single pass over
+ * each line.
+ *
+ * This function fails on a malformed _FILE_, _TRACK_, _INDEX_,
+ * _PREGAP_ or _POSTGAP_ entry, on tracks out of sequence and when it
+ * is impossible to read some line of the input stream.
+ *
+ * \sa
+ * - Next step:
+ *   + ::cue2ccd
+ *
+ */
+
+int stream2cue (FILE *stream, struct cue *cue)
+  __attribute__ ((nonnull));
+
+/**
+ * Free a _CUE structure_.
+ *
+ * \param[in]  cue  _CUE structure_ allocated by ::cue_init;
+ *
+ * \since 0.3
+ *
+ * Every array and string the structure points to is freed, as well
+ * as the structure itself.
+ *
+ */
+
+void cue_free (struct cue *cue)
+  __attribute__ ((nonnull));
+
 #endif	/* CCD2CUE_CUE_H */
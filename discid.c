@@ -0,0 +1,186 @@
+/*
+ discid.c -- Disc identifiers;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       discid.c
+ * \brief      Disc identifiers
+ */
+
+
+#include "config.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "errors.h"
+#include "ccd.h"
+#include "sha1.h"
+#include "discid.h"
+
+
+/** Number of possible track numbers; */
+#define DISCID_TRACKS 100
+
+/** Offset of the first sector of the disc image in frames; */
+#define DISCID_LEAD_IN 150
+
+/** How many frames a second has; */
+#define DISCID_FRAMES_PER_SECOND 75
+
+
+/**
+ * Encode a SHA-1 digest the way MusicBrainz does.
+ *
+ * \param[in]   digest  Digest;
+ * \param[out]  text    Encoded digest, ::DISCID_MUSICBRAINZ_LENGTH
+ *                      characters long and null terminated;
+ *
+ * \since 0.3
+ *
+ */
+
+static void discid_base64 (const uint8_t digest[SHA1_DIGEST_SIZE],
+			   char text[DISCID_MUSICBRAINZ_LENGTH + 1])
+  __attribute__ ((nonnull));
+
+/**
+ * Sum the decimal digits of a number.
+ *
+ * \param[in]  n  Number;
+ *
+ * \return The sum of the decimal digits of N.
+ *
+ * \since 0.3
+ *
+ */
+
+static int discid_digit_sum (int n)
+  __attribute__ ((const));
+
+
+int
+ccd2discid (const struct ccd *ccd, struct discid *discid)
+{
+  int offset[DISCID_TRACKS];	/* Position of each track in the first
+				   session, or 0; */
+  int first = DISCID_TRACKS, last = 0; /* First and last tracks of
+					  the first session; */
+  int leadout = -1;		/* Lead-out of the first session; */
+  int disc_first = -1;		/* Position of the first track; */
+  int disc_leadout = -1;	/* Lead-out of the last session; */
+  int tracks = 0;		/* Number of tracks; */
+  int sum = 0;			/* Sum of digits of track positions; */
+  char text[2 + 2 + 8 * DISCID_TRACKS + 1]; /* MusicBrainz hash
+					       input; */
+  uint8_t digest[SHA1_DIGEST_SIZE]; /* MusicBrainz hash; */
+  char *p = text;		/* Current position in TEXT; */
+  int i;			/* Entry index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the disc identifiers are valid. */
+  assert (discid != NULL);
+
+  memset (offset, 0, sizeof (offset));
+
+  /* Gather the TOC in a single pass. */
+  for (i = 0; i < ccd->Disc.TocEntries; i++)
+    {
+      const struct ccd_Entry *Entry = &ccd->Entry[i];
+      int position = Entry->PLBA + DISCID_LEAD_IN;
+
+      if (Entry->Point >= 1 && Entry->Point < DISCID_TRACKS)
+	{
+	  /* Every session counts for freedb. */
+	  tracks++;
+	  sum += discid_digit_sum (position / DISCID_FRAMES_PER_SECOND);
+	  if (disc_first < 0 || position < disc_first) disc_first = position;
+
+	  /* Only the first one for MusicBrainz. */
+	  if (Entry->Session <= 1)
+	    {
+	      offset[Entry->Point] = position;
+	      if ((int) Entry->Point < first) first = Entry->Point;
+	      if ((int) Entry->Point > last) last = Entry->Point;
+	    }
+	}
+      else if (Entry->Point == 0xa2)
+	{
+	  if (Entry->Session <= 1) leadout = position;
+	  if (position > disc_leadout) disc_leadout = position;
+	}
+    }
+
+  if (last == 0 || leadout < 0)
+    error_push (-1, "the TOC lacks tracks or a lead-out");
+
+  /* MusicBrainz. */
+  p += sprintf (p, "%02X%02X%08X", first, last, leadout);
+  for (i = 1; i < DISCID_TRACKS; i++)
+    p += sprintf (p, "%08X", offset[i]);
+
+  sha1 (text, p - text, digest);
+  discid_base64 (digest, discid->musicbrainz);
+
+  /* freedb. */
+  discid->freedb = (uint32_t) (sum % 0xff) << 24
+    | (uint32_t) (disc_leadout / DISCID_FRAMES_PER_SECOND
+		  - disc_first / DISCID_FRAMES_PER_SECOND) << 8
+    | (uint32_t) tracks;
+
+  /* Return success. */
+  return 0;
+}
+
+static void
+discid_base64 (const uint8_t digest[SHA1_DIGEST_SIZE],
+	       char text[DISCID_MUSICBRAINZ_LENGTH + 1])
+{
+  static const char alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789._";
+  int i, j;			/* Digest and text indexes; */
+
+  /* Encode 3 bytes into 4 characters at a time, padding the last
+     group, which has only 2 bytes. */
+  for (i = j = 0; i < SHA1_DIGEST_SIZE; i += 3)
+    {
+      uint32_t group = (uint32_t) digest[i] << 16
+	| (i + 1 < SHA1_DIGEST_SIZE ? (uint32_t) digest[i + 1] << 8 : 0)
+	| (i + 2 < SHA1_DIGEST_SIZE ? digest[i + 2] : 0);
+
+      text[j++] = alphabet[(group >> 18) & 0x3f];
+      text[j++] = alphabet[(group >> 12) & 0x3f];
+      text[j++] = i + 1 < SHA1_DIGEST_SIZE ? alphabet[(group >> 6) & 0x3f] : '-';
+      text[j++] = i + 2 < SHA1_DIGEST_SIZE ? alphabet[group & 0x3f] : '-';
+    }
+
+  text[j] = '\0';
+}
+
+static int
+discid_digit_sum (int n)
+{
+  int sum = 0;			/* Sum so far; */
+
+  for (; n > 0; n /= 10) sum += n % 10;
+
+  return sum;
+}
@@ -0,0 +1,91 @@
+/*
+ discid.h -- Disc identifiers;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       discid.h
+ * \brief      Disc identifiers
+ */
+
+
+#ifndef CCD2CUE_DISCID_H
+#define CCD2CUE_DISCID_H
+
+#include <stdint.h>
+
+#include "ccd.h"
+
+/**
+ * Length of a MusicBrainz disc ID in characters.
+ */
+
+#define DISCID_MUSICBRAINZ_LENGTH 28
+
+/**
+ * Disc identifiers
+ *
+ * Both identifiers are derived from the TOC alone, so they are the
+ * same for every copy of a disc, whatever drive or ripper made it.
+ *
+ */
+
+struct discid
+{
+  char musicbrainz[DISCID_MUSICBRAINZ_LENGTH + 1]; /**< MusicBrainz disc
+						      ID. */
+  uint32_t freedb;		/**< freedb disc ID, also known as
+				   CDDB disc ID. */
+};
+
+/**
+ * Calculate the identifiers of a disc from its TOC.
+ *
+ * \param[in]   ccd     _CCD structure_;
+ * \param[out]  discid  Disc identifiers;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * The TOC is taken from the _Entry_ sections, whose _Point_ is the
+ * track number for tracks, 0xA0 for the first track, 0xA1 for the
+ * last one and 0xA2 for the lead-out.  Positions count the 150
+ * frames of the lead-in, as audio players see them.
+ *
+ * The MusicBrainz disc ID is the SHA-1 digest of the first and last
+ * track numbers, the lead-out and 99 track positions, 0 for missing
+ * tracks, all written as upper case hexadecimal.  It is encoded in
+ * base 64 with '.', '_' and '-' instead of '+', '/' and '='.  Only
+ * the first session counts, so the data track of an enhanced CD is
+ * left out.
+ *
+ * The freedb disc ID packs the sum of the decimal digits of the
+ * position in seconds of every track, modulo 255, the length of the
+ * disc in seconds and the number of tracks, from the most to the
+ * least significant byte.  Every session counts.
+ *
+ * A TOC lacking a lead-out or tracks is a failure.
+ *
+ */
+
+int ccd2discid (const struct ccd *ccd, struct discid *discid)
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_DISCID_H */
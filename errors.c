@@ -111,3 +111,23 @@ error_pop_f (void)
   error_entries = 0;
   exit(EX_DATAERR);
 }
+
+
+void
+error_flush (void)
+{
+  size_t i;
+
+  /* Print every error message from error stack in a bottom-top
+     fashion, a line each.  Empty error stack. */
+
+  for (i = 0; i < error_entries; i++)
+    {
+      fprintf (stderr, "%s\n", error_stack[i]);
+      free (error_stack[i]);
+    }
+
+  free (error_stack);
+  error_stack = NULL;
+  error_entries = 0;
+}
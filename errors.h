@@ -59,6 +59,23 @@ void error_push_f (const char function_name[], const char *template, ...)
 
 void error_pop_f (void);
 
+/**
+ * Print all error stack's messages and empty error stack, without
+ * exiting.
+ *
+ * \since 0.3
+ *
+ * The messages are shown in a bottom-top fashion on standard error, a
+ * line each.  It is useful for reporting why one of many files failed
+ * before going on with the next, so the messages of a file are neither
+ * lost nor shown along with those of another.
+ *
+ * \sa ::error_pop_f
+ *
+ **/
+
+void error_flush (void);
+
 
 /**
  * Push an error message for the executing function and return STATUS.
@@ -27,6 +27,7 @@
 
 #include "config.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "array.h"
@@ -62,3 +63,15 @@ make_reference_name (const char *filename, const int dirname_flag)
   /* Return to the caller the wanted reference name */
   return str;
 }
+
+char *
+make_track_name (const char *reference_name, int track, const char *extension)
+{
+  char number[2 + 1];		/* Two digit track number; */
+
+  /* Track numbers range from 1 to 99. */
+  snprintf (number, sizeof (number), "%02u", (unsigned int) track % 100);
+
+  /* Put the pieces together. */
+  return concat (reference_name, " (Track ", number, ")", extension, NULL);
+}
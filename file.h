@@ -59,4 +59,34 @@
 
 char * make_reference_name (const char *filename, const int dirname_flag);
 
+/**
+ * Make a track file name from a reference name.
+ *
+ * \param[in] reference_name  Reference name of the disc.
+ * \param[in] track           Track number.
+ * \param[in] extension       File name extension, including the
+ *                            leading dot.
+ *
+ * \return
+ * + Success: the track file name as a new malloc'ed string.
+ * + Failure: a NULL pointer.
+ *
+ * \note This function can fail only if it's impossible to malloc the
+ * resulting track file name string.
+ *
+ * \since 0.3
+ *
+ * The track file name has the form "REFERENCE_NAME (Track NN)EXTENSION",
+ * where NN is the two digit track number.  For instance, the file of
+ * track 2 for the reference name 'qux/foo' and extension '.bin' is
+ * 'qux/foo (Track 02).bin'.
+ *
+ * \sa ::make_reference_name
+ *
+ */
+
+char * make_track_name (const char *reference_name, int track,
+			const char *extension)
+  __attribute__ ((nonnull));
+
 #endif	/* CCD2CUE_FILE_H */
@@ -0,0 +1,338 @@
+/*
+ fingerprint.c -- TOC fingerprints;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       fingerprint.c
+ * \brief      TOC fingerprints
+ */
+
+
+#include "config.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/types.h>
+
+#include "memory.h"
+#include "errors.h"
+#include "io.h"
+#include "ccd.h"
+#include "fingerprint.h"
+
+
+/** FNV-1a 64 bit offset basis; */
+#define FNV64_BASIS UINT64_C (0xcbf29ce484222325)
+
+/** FNV-1a 64 bit prime; */
+#define FNV64_PRIME UINT64_C (0x100000001b3)
+
+
+/**
+ * Compare two _Entry_ sections by session and point.
+ *
+ * \param[in]  a  Pointer to the first _Entry_ section;
+ * \param[in]  b  Pointer to the second _Entry_ section;
+ *
+ * \return Less than, equal to, or greater than zero if A goes before,
+ *         along with, or after B.
+ *
+ * \since 0.3
+ *
+ */
+
+static int fingerprint_entry_cmp (const void *a, const void *b)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Compare two fingerprint index entries.
+ *
+ * \param[in]  a  Pointer to the first entry;
+ * \param[in]  b  Pointer to the second entry;
+ *
+ * \return Less than, equal to, or greater than zero if A goes before,
+ *         along with, or after B, by fingerprint and then by name.
+ *
+ * \since 0.3
+ *
+ */
+
+static int fingerprint_cmp (const void *a, const void *b)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Store a 64 bit little endian integer.
+ *
+ * \param[out]  p  Destination;
+ * \param[in]   v  Value;
+ *
+ * \since 0.3
+ *
+ */
+
+static void fingerprint_put_le64 (uint8_t *p, uint64_t v)
+  __attribute__ ((nonnull));
+
+/**
+ * Load a 64 bit little endian integer.
+ *
+ * \param[in]  p  Source;
+ *
+ * \return The value.
+ *
+ * \since 0.3
+ *
+ */
+
+static uint64_t fingerprint_get_le64 (const uint8_t *p)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Read a 64 bit little endian integer from a stream at an offset.
+ *
+ * \param[in]   stream  Input stream;
+ * \param[in]   offset  Offset in bytes;
+ * \param[out]  v       Value;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ */
+
+static int fingerprint_read_le64 (FILE *stream, off_t offset, uint64_t *v)
+  __attribute__ ((nonnull));
+
+
+int
+ccd2fingerprint (const struct ccd *ccd, uint64_t *fingerprint)
+{
+  const struct ccd_Entry **Entry; /* Entries in canonical order; */
+  uint64_t hash = FNV64_BASIS;	/* Hash accumulator; */
+  int tracks = 0;		/* Track points found; */
+  int i;			/* Entry index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the fingerprint pointer is valid. */
+  assert (fingerprint != NULL);
+
+  for (i = 0; i < ccd->Disc.TocEntries; i++)
+    if (ccd->Entry[i].Point >= 1 && ccd->Entry[i].Point <= 99) tracks++;
+
+  if (tracks == 0)
+    error_push (-1, "the TOC lacks tracks");
+
+  /* Sort pointers to the entries, leaving the structure alone. */
+  Entry = xmalloc (sizeof (*Entry) * (ccd->Disc.TocEntries + 1));
+  for (i = 0; i < ccd->Disc.TocEntries; i++)
+    Entry[i] = &ccd->Entry[i];
+  qsort (Entry, ccd->Disc.TocEntries, sizeof (*Entry), fingerprint_entry_cmp);
+
+  for (i = 0; i < ccd->Disc.TocEntries; i++)
+    {
+      uint8_t data[10];		/* Canonical form of the entry; */
+      size_t j;			/* Byte index; */
+
+      /* The position is taken in MSF too, as for points A0 and A1 it
+	 carries the first and last track numbers and the disc type
+	 rather than a time. */
+      data[0] = Entry[i]->Session & 0xff;
+      data[1] = Entry[i]->Point & 0xff;
+      data[2] = Entry[i]->Control & 0xff;
+      data[3] = Entry[i]->PMin & 0xff;
+      data[4] = Entry[i]->PSec & 0xff;
+      data[5] = Entry[i]->PFrame & 0xff;
+      data[6] = Entry[i]->PLBA & 0xff;
+      data[7] = (Entry[i]->PLBA >> 8) & 0xff;
+      data[8] = (Entry[i]->PLBA >> 16) & 0xff;
+      data[9] = (Entry[i]->PLBA >> 24) & 0xff;
+
+      for (j = 0; j < sizeof (data); j++)
+	hash = (hash ^ data[j]) * FNV64_PRIME;
+    }
+
+  free (Entry);
+
+  *fingerprint = hash;
+
+  /* Return success. */
+  return 0;
+}
+
+void
+fingerprint2stream (struct fingerprint *entries, size_t count, FILE *stream)
+{
+  uint8_t buffer[FINGERPRINT_RECORD_SIZE]; /* Header or record; */
+  uint64_t offset = 0;		/* Offset of the next name; */
+  size_t i;			/* Entry index; */
+
+  /* Assert the entries are valid. */
+  assert (entries != NULL);
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  qsort (entries, count, sizeof (*entries), fingerprint_cmp);
+
+  /* Header. */
+  memcpy (buffer, FINGERPRINT_MAGIC, 8);
+  fingerprint_put_le64 (buffer + 8, count);
+  xfwrite (buffer, FINGERPRINT_HEADER_SIZE, 1, stream);
+
+  /* Records. */
+  for (i = 0; i < count; i++)
+    {
+      fingerprint_put_le64 (buffer, entries[i].fingerprint);
+      fingerprint_put_le64 (buffer + 8, offset);
+      xfwrite (buffer, FINGERPRINT_RECORD_SIZE, 1, stream);
+      offset += strlen (entries[i].name) + 1;
+    }
+
+  /* String table. */
+  for (i = 0; i < count; i++)
+    xfwrite (entries[i].name, strlen (entries[i].name) + 1, 1, stream);
+}
+
+long
+fingerprint_query (FILE *index, uint64_t fingerprint, FILE *stream)
+{
+  uint8_t header[FINGERPRINT_HEADER_SIZE]; /* Header; */
+  uint64_t count;		/* Number of records; */
+  uint64_t lo, hi;		/* Search range of records; */
+  off_t names;			/* Offset of the string table; */
+  long found = 0;		/* Entries found; */
+
+  /* Assert the index stream is valid. */
+  assert (index != NULL);
+
+  /* Assert the output stream is valid. */
+  assert (stream != NULL);
+
+  if (fseeko (index, 0, SEEK_SET) == -1
+      || fread (header, sizeof (header), 1, index) != 1
+      || memcmp (header, FINGERPRINT_MAGIC, 8) != 0)
+    error_push (-1, "not a fingerprint index");
+
+  count = fingerprint_get_le64 (header + 8);
+  names = FINGERPRINT_HEADER_SIZE + (off_t) count * FINGERPRINT_RECORD_SIZE;
+
+  /* Find the first record not less than the fingerprint. */
+  for (lo = 0, hi = count; lo < hi;)
+    {
+      uint64_t mid = lo + (hi - lo) / 2; /* Record probed; */
+      uint64_t v;		/* Its fingerprint; */
+
+      if (fingerprint_read_le64 (index, FINGERPRINT_HEADER_SIZE
+				 + (off_t) mid * FINGERPRINT_RECORD_SIZE, &v) < 0)
+	error_push (-1, "cannot search fingerprint index");
+
+      if (v < fingerprint) lo = mid + 1;
+      else hi = mid;
+    }
+
+  /* Write out every name from there on, while the fingerprint
+     matches. */
+  for (; lo < count; lo++)
+    {
+      off_t record = FINGERPRINT_HEADER_SIZE
+	+ (off_t) lo * FINGERPRINT_RECORD_SIZE; /* Record offset; */
+      uint64_t v, offset;	/* Its fingerprint and name offset; */
+      int c;			/* Name character; */
+
+      if (fingerprint_read_le64 (index, record, &v) < 0
+	  || fingerprint_read_le64 (index, record + 8, &offset) < 0)
+	error_push (-1, "cannot search fingerprint index");
+
+      if (v != fingerprint) break;
+
+      if (fseeko (index, names + (off_t) offset, SEEK_SET) == -1)
+	error_push_lib (fseeko, -1, "cannot search fingerprint index");
+
+      while ((c = getc (index)) != EOF && c != '\0')
+	xputc (c, stream);
+      xputc ('\n', stream);
+
+      if (c == EOF) error_push (-1, "truncated fingerprint index");
+      found++;
+    }
+
+  return found;
+}
+
+static int
+fingerprint_entry_cmp (const void *a, const void *b)
+{
+  const struct ccd_Entry *x = *(const struct ccd_Entry * const *) a;
+  const struct ccd_Entry *y = *(const struct ccd_Entry * const *) b;
+
+  if (x->Session != y->Session) return x->Session < y->Session ? -1 : 1;
+  if (x->Point != y->Point) return x->Point < y->Point ? -1 : 1;
+  return 0;
+}
+
+static int
+fingerprint_cmp (const void *a, const void *b)
+{
+  const struct fingerprint *x = a, *y = b;
+
+  if (x->fingerprint != y->fingerprint)
+    return x->fingerprint < y->fingerprint ? -1 : 1;
+  return strcmp (x->name, y->name);
+}
+
+static void
+fingerprint_put_le64 (uint8_t *p, uint64_t v)
+{
+  int i;			/* Byte index; */
+
+  for (i = 0; i < 8; i++)
+    p[i] = (v >> (8 * i)) & 0xff;
+}
+
+static uint64_t
+fingerprint_get_le64 (const uint8_t *p)
+{
+  uint64_t v = 0;		/* Value; */
+  int i;			/* Byte index; */
+
+  for (i = 7; i >= 0; i--)
+    v = (v << 8) | p[i];
+
+  return v;
+}
+
+static int
+fingerprint_read_le64 (FILE *stream, off_t offset, uint64_t *v)
+{
+  uint8_t buffer[8];		/* Bytes read; */
+
+  if (fseeko (stream, offset, SEEK_SET) == -1
+      || fread (buffer, sizeof (buffer), 1, stream) != 1)
+    error_push (-1, "cannot read at offset %ld", (long) offset);
+
+  *v = fingerprint_get_le64 (buffer);
+
+  /* Return success. */
+  return 0;
+}
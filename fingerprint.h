@@ -0,0 +1,148 @@
+/*
+ fingerprint.h -- TOC fingerprints;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       fingerprint.h
+ * \brief      TOC fingerprints
+ */
+
+
+#ifndef CCD2CUE_FINGERPRINT_H
+#define CCD2CUE_FINGERPRINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ccd.h"
+
+/**
+ * Magic number opening a fingerprint index file.
+ */
+
+#define FINGERPRINT_MAGIC "CCDTOCX1"
+
+/**
+ * Size of the header of a fingerprint index file in bytes.
+ *
+ * The header holds ::FINGERPRINT_MAGIC followed by the number of
+ * records.
+ *
+ */
+
+#define FINGERPRINT_HEADER_SIZE 16
+
+/**
+ * Size of a record of a fingerprint index file in bytes.
+ *
+ * A record holds a fingerprint followed by the offset of its name in
+ * the string table, which follows the last record.
+ *
+ */
+
+#define FINGERPRINT_RECORD_SIZE 16
+
+/**
+ * Fingerprint index entry
+ *
+ * Every entry ties the fingerprint of a disc layout to the name of a
+ * _CCD sheet_ having it.
+ *
+ */
+
+struct fingerprint
+{
+  uint64_t fingerprint;		/**< Fingerprint of the TOC. */
+  const char *name;		/**< _CCD sheet_ file name. */
+};
+
+/**
+ * Calculate the fingerprint of the TOC of a _CCD structure_.
+ *
+ * \param[in]   ccd          _CCD structure_;
+ * \param[out]  fingerprint  Fingerprint;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * The session, point, control field, _PMin_, _PSec_, _PFrame_ and
+ * _PLBA_ of every _Entry_ section are hashed with FNV-1a, 64 bit.  Entries are taken in
+ * session and point order, so sheets listing them differently still
+ * agree, while anything else about the sheet, including its name,
+ * does not matter.
+ *
+ * A TOC lacking track points, 1 to 99, is a failure, as every such
+ * sheet, e.g. a CUE sheet given by mistake, would otherwise share the
+ * same fingerprint.
+ *
+ */
+
+int ccd2fingerprint (const struct ccd *ccd, uint64_t *fingerprint)
+  __attribute__ ((nonnull));
+
+/**
+ * Write a fingerprint index.
+ *
+ * \param[in,out]  entries  Entries, sorted by fingerprint on return;
+ * \param[in]      count    Number of entries;
+ * \param[out]     stream   Output stream;
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ * \since 0.3
+ *
+ * The index is made of a header of ::FINGERPRINT_HEADER_SIZE bytes, a
+ * record of ::FINGERPRINT_RECORD_SIZE bytes for each entry in
+ * fingerprint order, and a table of the null terminated names.  All
+ * numbers are 64 bit little endian.  Fixed size records let
+ * ::fingerprint_query binary search the file in place.
+ *
+ */
+
+void fingerprint2stream (struct fingerprint *entries, size_t count,
+			 FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Look up a fingerprint in a fingerprint index.
+ *
+ * \param[in]   index        Fingerprint index stream, as written by
+ *                           ::fingerprint2stream;
+ * \param[in]   fingerprint  Fingerprint;
+ * \param[out]  stream       Output stream;
+ *
+ * \return
+ * + >=0  number of entries found;
+ * + <0   failure
+ *
+ * \since 0.3
+ *
+ * The name of every entry having FINGERPRINT is written to STREAM, a
+ * line each.  Records are binary searched, so only about log2 of the
+ * number of entries records are read, besides the matching ones.
+ *
+ */
+
+long fingerprint_query (FILE *index, uint64_t fingerprint, FILE *stream)
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_FINGERPRINT_H */
@@ -0,0 +1,848 @@
+/*
+ image.c -- Disc image handling;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       image.c
+ * \brief      Disc image handling
+ */
+
+
+#include "config.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "memory.h"
+#include "errors.h"
+#include "io.h"
+#include "ccd.h"
+#include "swap.h"
+#include "sub.h"
+#include "image.h"
+
+
+/**
+ * Copy a byte range of a disc image to a stream through a buffer.
+ *
+ * \param[in]   image      Disc image stream;
+ * \param[in]   offset     Offset of the range in bytes;
+ * \param[in]   length     Length of the range in bytes;
+ * \param[out]  stream     Output stream;
+ * \param[in]   swap_flag  Whether to swap the byte order of samples;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * This is the portable fallback of ::image_copy, and the only way to
+ * copy when the byte order of samples must be swapped with ::swap16
+ * on the way.  If the disc image ends before the range does, the copy
+ * stops there and it is not considered a failure.
+ *
+ */
+
+static int image_copy_buffered (FILE *image, off_t offset, off_t length,
+				FILE *stream, int swap_flag)
+  __attribute__ ((nonnull));
+
+/**
+ * Get the byte range of a track in a disc image.
+ *
+ * \param[in]   ccd    _CCD structure_;
+ * \param[in]   track  Track number;
+ * \param[in]   size   Disc image size in bytes;
+ * \param[out]  start  Offset of the track in bytes;
+ * \param[out]  end    Offset right after the track in bytes;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * Each track spans from its first sector, as given by
+ * ::image_track_start, up to the first sector of the next track.  The
+ * last track spans up to the end of the disc image.  No range goes
+ * beyond the end of the disc image.
+ *
+ */
+
+static int image_track_range (const struct ccd *ccd, int track, off_t size,
+			      off_t *start, off_t *end)
+  __attribute__ ((nonnull));
+
+/**
+ * Write silence to a stream.
+ *
+ * \param[out]  stream  Output stream;
+ * \param[in]   length  Length of the silence in bytes;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ */
+
+static int image_silence (FILE *stream, off_t length)
+  __attribute__ ((nonnull));
+
+/**
+ * Check whether a sector is digital silence.
+ *
+ * \param[in]  sector  Sector of ::IMAGE_SECTOR_SIZE bytes;
+ *
+ * \return
+ * + !=0  all the bytes are zero;
+ * + =0   otherwise;
+ *
+ * \since 0.3
+ *
+ */
+
+static int image_silent (const uint8_t *sector)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Store a 16 bit little endian integer.
+ *
+ * \param[out]  p  Destination;
+ * \param[in]   v  Value;
+ *
+ * \since 0.3
+ *
+ */
+
+static void image_put_le16 (uint8_t *p, uint16_t v)
+  __attribute__ ((nonnull));
+
+/**
+ * Store a 32 bit little endian integer.
+ *
+ * \param[out]  p  Destination;
+ * \param[in]   v  Value;
+ *
+ * \since 0.3
+ *
+ */
+
+static void image_put_le32 (uint8_t *p, uint32_t v)
+  __attribute__ ((nonnull));
+
+
+off_t
+image_size (FILE *stream)
+{
+  /* Information about STREAM's attributes; */
+  struct stat stat;
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  /* Get the information about STREAM's attributes.  Push an error if
+     you cannot. */
+  if (fstat (fileno (stream), &stat) == -1)
+    error_push_lib (fstat, -1, "cannot get disc image size");
+
+  /* Return the size in bytes. */
+  return stat.st_size;
+}
+
+off_t
+image_file_size (const char *name)
+{
+  /* Information about NAME's attributes; */
+  struct stat stat_buf;
+
+  /* Assert the name is valid. */
+  assert (name != NULL);
+
+  if (stat (name, &stat_buf) == -1)
+    error_push_lib (stat, -1, "cannot get size of '%s'", name);
+
+  /* Return the size in bytes. */
+  return stat_buf.st_size;
+}
+
+int
+image_track_start (const struct ccd *ccd, int track)
+{
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the track exists. */
+  assert (track >= 1 && track <= ccd->TrackEntries);
+
+  /* If there is a pre-gap, the track starts on it. */
+  if (ccd->TRACK[track].INDEX[0] != -1)
+    return ccd->TRACK[track].INDEX[0];
+
+  /* Otherwise, the track starts on its data, if any. */
+  return ccd->TRACK[track].INDEX[1];
+}
+
+int
+image_copy (FILE *image, off_t offset, off_t length, FILE *stream,
+	    int swap_flag)
+{
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Assert the output stream is valid. */
+  assert (stream != NULL);
+
+  /* Assert the range is valid. */
+  assert (offset >= 0 && length >= 0);
+
+  /* Make sure anything already written to the output stream reaches
+     its file descriptor before the range. */
+  if (fflush (stream) == EOF)
+    error_push_lib (fflush, -1, "cannot copy disc image range");
+
+#ifdef __linux__
+  if (! swap_flag)
+  {
+    loff_t in_offset = offset;	/* Input offset; updated by the
+				   kernel; */
+
+    /* Let the kernel copy, and possibly reflink, the range. */
+    while (length > 0)
+      {
+	ssize_t copied = copy_file_range (fileno (image), &in_offset,
+					  fileno (stream), NULL, length, 0);
+
+	/* The disc image ended before the range did. */
+	if (copied == 0) return 0;
+
+	/* The file systems in question do not support it; fall back
+	   to copy the remainder through a buffer. */
+	if (copied < 0)
+	  {
+	    if (errno == ENOSYS || errno == EXDEV || errno == EINVAL
+		|| errno == EOPNOTSUPP)
+	      break;
+	    error_push_lib (copy_file_range, -1, "cannot copy disc image range");
+	  }
+
+	length -= copied;
+      }
+
+    offset = in_offset;
+    if (length == 0) return 0;
+
+    /* The output stream offset was moved behind stdio's back; make
+       it aware of that before writing to it again. */
+    if (fseeko (stream, 0, SEEK_END) == -1)
+      error_push_lib (fseeko, -1, "cannot copy disc image range");
+  }
+#endif
+
+  return image_copy_buffered (image, offset, length, stream, swap_flag);
+}
+
+int
+image_split (const struct ccd *ccd, FILE *image, char *const *file_names,
+	     const enum cue_filetype *file_types)
+{
+  off_t size;			/* Disc image size in bytes; */
+  int track;			/* Track number; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Assert the file names array is valid. */
+  assert (file_names != NULL);
+
+  /* Assert the file types array is valid. */
+  assert (file_types != NULL);
+
+  /* The last track spans up to the end of the disc image. */
+  size = image_size (image);
+  if (size < 0) error_push (-1, "cannot split disc image");
+
+  /* Carve out each track. */
+  for (track = 1; track <= ccd->TrackEntries; track++)
+    {
+      FILE *stream;		/* Track file stream; */
+      off_t start, end;		/* Track range in bytes; */
+      int status;		/* Status of writing the track file; */
+
+      /* Find where this track begins and ends. */
+      if (image_track_range (ccd, track, size, &start, &end) < 0)
+	error_push (-1, "cannot split disc image");
+
+      /* Do not create a file that cannot be written. */
+      if (file_types[track] != WAVE && file_types[track] != MOTOROLA
+	  && file_types[track] != BINARY)
+	error_push (-1, "cannot write '%s' with type %d", file_names[track],
+		    file_types[track]);
+
+      /* Write the track file according to its type. */
+      stream = fopen (file_names[track], "wb");
+      if (stream == NULL)
+	error_push_lib (fopen, -1, "cannot create '%s'", file_names[track]);
+
+      switch (file_types[track])
+	{
+	case WAVE:		/* Audio samples after a RIFF header; */
+	  status = image_wave (image, start, end - start, stream);
+	  break;
+	case MOTOROLA:		/* Big endian audio samples; */
+	  status = image_copy (image, start, end - start, stream,
+			       ccd->TRACK[track].MODE == 0);
+	  break;
+	default:		/* Verbatim copy; */
+	  status = image_copy (image, start, end - start, stream, 0);
+	}
+
+      if (status < 0)
+	{
+	  /* Leave no partial track file behind. */
+	  fclose (stream);
+	  remove (file_names[track]);
+	  error_push (-1, "cannot write '%s'", file_names[track]);
+	}
+
+      if (fclose (stream) == EOF)
+	{
+	  int error = errno;	/* Reason fclose failed; */
+
+	  remove (file_names[track]);
+	  errno = error;
+	  error_push_lib (fclose, -1, "cannot close '%s'", file_names[track]);
+	}
+    }
+
+  /* Return success. */
+  return 0;
+}
+
+int
+image_wave (FILE *image, off_t offset, off_t length, FILE *stream)
+{
+  uint8_t header[IMAGE_WAVE_HEADER_SIZE]; /* RIFF header; */
+  uint32_t riff_size;		/* RIFF chunk size; */
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Assert the output stream is valid. */
+  assert (stream != NULL);
+
+  /* A RIFF file cannot hold more than 4 GiB. */
+  if (length > UINT32_MAX - (IMAGE_WAVE_HEADER_SIZE - 8))
+    error_push (-1, "track too long for a WAVE file");
+
+  /* Build the canonical 44 byte header for 44.1 kHz, 16 bit, stereo
+     PCM, all fields being little endian. */
+  riff_size = (uint32_t) length + IMAGE_WAVE_HEADER_SIZE - 8;
+  memcpy (header, "RIFF", 4);
+  image_put_le32 (header + 4, riff_size);
+  memcpy (header + 8, "WAVEfmt ", 8);
+  image_put_le32 (header + 16, 16);	      /* Format chunk size; */
+  image_put_le16 (header + 20, 1);	      /* PCM; */
+  image_put_le16 (header + 22, 2);	      /* Channels; */
+  image_put_le32 (header + 24, 44100);	      /* Sample rate; */
+  image_put_le32 (header + 28, 44100 * 2 * 2); /* Byte rate; */
+  image_put_le16 (header + 32, 2 * 2);	      /* Block align; */
+  image_put_le16 (header + 34, 16);	      /* Bits per sample; */
+  memcpy (header + 36, "data", 4);
+  image_put_le32 (header + 40, (uint32_t) length);
+
+  /* Write the header and stream the samples right after it.  They
+     are already little endian in the disc image. */
+  if (fwrite (header, 1, sizeof (header), stream) != sizeof (header))
+    error_push_lib (fwrite, -1, "cannot write WAVE header");
+
+  return image_copy (image, offset, length, stream, 0);
+}
+
+int
+image_swap (const struct ccd *ccd, FILE *image, FILE *stream)
+{
+  off_t size;			/* Disc image size in bytes; */
+  off_t offset = 0;		/* Offset already written in bytes; */
+  int track;			/* Track number; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Assert the output stream is valid. */
+  assert (stream != NULL);
+
+  size = image_size (image);
+  if (size < 0) error_push (-1, "cannot swap disc image");
+
+  /* Copy each track, swapping audio tracks only.  Anything before
+     the first track is copied verbatim along with it. */
+  for (track = 1; track <= ccd->TrackEntries; track++)
+    {
+      off_t start, end;		/* Track range in bytes; */
+
+      if (image_track_range (ccd, track, size, &start, &end) < 0)
+	error_push (-1, "cannot swap disc image");
+
+      if (start > offset
+	  && image_copy (image, offset, start - offset, stream, 0) < 0)
+	error_push (-1, "cannot swap disc image");
+
+      if (image_copy (image, start, end - start, stream,
+		      ccd->TRACK[track].MODE == 0) < 0)
+	error_push (-1, "cannot swap disc image");
+
+      offset = end;
+    }
+
+  /* Copy anything trailing the last track verbatim. */
+  if (offset < size
+      && image_copy (image, offset, size - offset, stream, 0) < 0)
+    error_push (-1, "cannot swap disc image");
+
+  /* Return success. */
+  return 0;
+}
+
+int
+image_offset (const struct ccd *ccd, FILE *image, FILE *stream,
+	      long samples)
+{
+  off_t size;			/* Disc image size in bytes; */
+  off_t offset = 0;		/* Offset already written in bytes; */
+  off_t shift = (off_t) samples * 4; /* Offset in bytes; */
+  int track;			/* Track number; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Assert the output stream is valid. */
+  assert (stream != NULL);
+
+  size = image_size (image);
+  if (size < 0) error_push (-1, "cannot shift disc image");
+
+  for (track = 1; track <= ccd->TrackEntries; track++)
+    {
+      off_t start, end;		/* Range of the run in bytes; */
+      off_t skip;		/* Silence before the samples; */
+      off_t lost;		/* Samples shifted out; */
+
+      if (image_track_range (ccd, track, size, &start, &end) < 0)
+	error_push (-1, "cannot shift disc image");
+
+      /* Copy anything before the track, and data tracks, verbatim. */
+      if (start > offset
+	  && image_copy (image, offset, start - offset, stream, 0) < 0)
+	error_push (-1, "cannot shift disc image");
+      offset = start;
+
+      if (ccd->TRACK[track].MODE != 0) continue;
+
+      /* Take in every following audio track as part of the run. */
+      while (track < ccd->TrackEntries && ccd->TRACK[track + 1].MODE == 0)
+	if (image_track_range (ccd, ++track, size, &start, &end) < 0)
+	  error_push (-1, "cannot shift disc image");
+
+      /* Silence comes in on one side as samples go out on the other,
+	 and the run may be shorter than the shift altogether. */
+      lost = shift < 0 ? -shift : shift;
+      if (lost > end - offset) lost = end - offset;
+      skip = shift < 0 ? lost : 0;
+
+      if (image_silence (stream, skip) < 0
+	  || image_copy (image, shift > 0 ? offset + lost : offset,
+			 end - offset - lost, stream, 0) < 0
+	  || image_silence (stream, lost - skip) < 0)
+	error_push (-1, "cannot shift disc image");
+
+      offset = end;
+    }
+
+  /* Copy anything trailing the last track verbatim. */
+  if (offset < size
+      && image_copy (image, offset, size - offset, stream, 0) < 0)
+    error_push (-1, "cannot shift disc image");
+
+  /* Return success. */
+  return 0;
+}
+
+int
+image_check (const struct ccd *ccd, off_t size, const char *name,
+	     FILE *stream)
+{
+  int leadout;			/* Lead-out in sectors; */
+  const char *status;		/* Size check status; */
+  int problems = 0;		/* Problems found; */
+  int track, x;			/* Track and index numbers; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the name is valid. */
+  assert (name != NULL);
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  leadout = ccd_leadout (ccd);
+  if (leadout < 0) status = "noleadout";
+  else if (size < (off_t) leadout * IMAGE_SECTOR_SIZE) status = "truncated";
+  else if (size > (off_t) leadout * IMAGE_SECTOR_SIZE) status = "oversized";
+  else status = "ok";
+
+  if (strcmp (status, "ok") != 0) problems++;
+  xfprintf (stream, "%s\t%s\t%d\t%lld\n", name, status, leadout,
+	    (long long) size);
+
+  /* Every index must begin inside the disc image. */
+  for (track = 1; track <= ccd->TrackEntries; track++)
+    for (x = 0; x < ccd->TRACK[track].IndexEntries; x++)
+      {
+	int sector = ccd->TRACK[track].INDEX[x]; /* Index sector; */
+
+	/* Unset indexes do not count. */
+	if (sector == -1) continue;
+
+	if (sector < 0 || (off_t) sector * IMAGE_SECTOR_SIZE >= size)
+	  {
+	    problems++;
+	    xfprintf (stream, "%s\tindex\t%d\t%d\t%d\n", name, track, x,
+		      sector);
+	  }
+      }
+
+  return problems;
+}
+
+int
+image_probe (const struct ccd *ccd, FILE *image, int track)
+{
+  static const uint8_t sync[12] = /* Sync pattern of data sectors; */
+    {0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00};
+  uint8_t *buffer;		/* Sectors read; */
+  int votes[3] = {0, 0, 0};	/* Sectors of each mode; */
+  int start;			/* First sector to read; */
+  int count;			/* Number of sectors to read; */
+  int mode;			/* Winning mode; */
+  int i;			/* Sector index; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Skip the pre-gap, which may well be of another mode. */
+  start = ccd->TRACK[track].IndexEntries > 1
+    && ccd->TRACK[track].INDEX[1] != -1
+    ? ccd->TRACK[track].INDEX[1] : image_track_start (ccd, track);
+  if (start < 0) error_push (-1, "track %d has no index", track);
+
+  /* Do not read into the next track. */
+  count = IMAGE_PROBE_SECTORS;
+  if (track < ccd->TrackEntries
+      && image_track_start (ccd, track + 1) - start < count)
+    count = image_track_start (ccd, track + 1) - start;
+
+  if (count < 1
+      || fseeko (image, (off_t) start * IMAGE_SECTOR_SIZE, SEEK_SET) == -1)
+    error_push (-1, "cannot probe track %d", track);
+
+  buffer = xmalloc (IMAGE_SECTOR_SIZE * count);
+  count = fread (buffer, IMAGE_SECTOR_SIZE, count, image);
+
+  for (i = 0; i < count; i++)
+    {
+      const uint8_t *p = buffer + i * IMAGE_SECTOR_SIZE;
+
+      /* The mode byte ends the 4 byte header following the sync
+	 pattern. */
+      if (memcmp (p, sync, sizeof (sync)) == 0 && (p[15] == 1 || p[15] == 2))
+	votes[p[15]]++;
+      else
+	votes[0]++;
+    }
+
+  free (buffer);
+
+  if (count < 1) error_push (-1, "cannot probe track %d", track);
+
+  /* Let the majority decide, audio winning ties. */
+  for (mode = 0, i = 1; i < 3; i++)
+    if (votes[i] > votes[mode]) mode = i;
+
+  return mode;
+}
+
+int
+image_gap (const struct ccd *ccd, FILE *image, int track)
+{
+  uint8_t *buffer;		/* Sectors read; */
+  int index1;			/* First sector of INDEX 01; */
+  int limit;			/* First sector that may be looked at; */
+  int gap;			/* First silent sector found so far; */
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  index1 = ccd->TRACK[track].IndexEntries > 1
+    ? ccd->TRACK[track].INDEX[1] : -1;
+  if (index1 < 0) error_push (-1, "track %d has no INDEX 01", track);
+
+  /* Stay within the window, leaving at least a sector to the previous
+     track. */
+  limit = index1 - IMAGE_GAP_WINDOW;
+  if (limit < 0) limit = 0;
+  if (track > 1 && ccd->TRACK[track - 1].IndexEntries > 1
+      && ccd->TRACK[track - 1].INDEX[1] >= limit)
+    limit = ccd->TRACK[track - 1].INDEX[1] + 1;
+
+  buffer = xmalloc (IMAGE_SECTOR_SIZE * IMAGE_GAP_MIN);
+
+  /* Walk backwards a chunk at a time, as long as it is silent. */
+  for (gap = index1; gap > limit;)
+    {
+      int first = gap - IMAGE_GAP_MIN < limit ? limit : gap - IMAGE_GAP_MIN;
+      int count = gap - first;	/* Sectors in this chunk; */
+      int i;			/* Sector index inside the chunk; */
+
+      if (fseeko (image, (off_t) first * IMAGE_SECTOR_SIZE, SEEK_SET) == -1
+	  || fread (buffer, IMAGE_SECTOR_SIZE, count, image) != (size_t) count)
+	{
+	  free (buffer);
+	  error_push_lib (fread, -1, "cannot scan the gap of track %d", track);
+	}
+
+      for (i = count; i-- > 0 && image_silent (buffer + i * IMAGE_SECTOR_SIZE);)
+	gap--;
+
+      /* Stop at the first sector with sound. */
+      if (i >= 0) break;
+    }
+
+  free (buffer);
+
+  /* Return the gap, if long enough. */
+  return index1 - gap >= IMAGE_GAP_MIN ? gap : index1;
+}
+
+int
+image_cdg (FILE *image, const struct sub *sub, FILE *stream)
+{
+  uint8_t *buffer;		/* Merge buffer; */
+  size_t sector = 0;		/* Sectors already written; */
+
+  /* Assert the disc image stream is valid. */
+  assert (image != NULL);
+
+  /* Assert the subchannel structure is valid. */
+  assert (sub != NULL);
+
+  /* Assert the output stream is valid. */
+  assert (stream != NULL);
+
+  if (fseeko (image, 0, SEEK_SET) == -1)
+    error_push_lib (fseeko, -1, "cannot merge subchannel data");
+
+  buffer = xmalloc (IMAGE_CDG_SECTOR_SIZE * IMAGE_CDG_BATCH);
+
+  for (;;)
+    {
+      size_t count;		/* Sectors read; */
+      size_t i;			/* Sector index inside the batch; */
+
+      /* Read a batch of sectors into the beginning of the buffer,
+	 then spread them out backwards, so none is overwritten
+	 before it is moved. */
+      count = fread (buffer, IMAGE_SECTOR_SIZE, IMAGE_CDG_BATCH, image);
+      for (i = count; i-- > 0;)
+	{
+	  uint8_t *p = buffer + i * IMAGE_CDG_SECTOR_SIZE;
+
+	  memmove (p, buffer + i * IMAGE_SECTOR_SIZE, IMAGE_SECTOR_SIZE);
+	  if (sector + i < sub->sectors)
+	    sub_interleave (&sub->sector[sector + i], p + IMAGE_SECTOR_SIZE, 1);
+	  else
+	    memset (p + IMAGE_SECTOR_SIZE, 0, SUB_SECTOR_SIZE);
+	}
+
+      if (count > 0
+	  && fwrite (buffer, IMAGE_CDG_SECTOR_SIZE, count, stream) != count)
+	{
+	  free (buffer);
+	  error_push_lib (fwrite, -1, "cannot merge subchannel data");
+	}
+      sector += count;
+
+      /* Stop at the end of the disc image, ignoring a trailing
+	 partial sector. */
+      if (count < IMAGE_CDG_BATCH) break;
+    }
+
+  free (buffer);
+
+  if (ferror (image))
+    error_push_lib (fread, -1, "cannot merge subchannel data");
+
+  /* Return success. */
+  return 0;
+}
+
+static int
+image_track_range (const struct ccd *ccd, int track, off_t size,
+		   off_t *start, off_t *end)
+{
+  /* Assert the start pointer is valid. */
+  assert (start != NULL);
+
+  /* Assert the end pointer is valid. */
+  assert (end != NULL);
+
+  /* Find where this track begins and where the next one does. */
+  if (image_track_start (ccd, track) < 0)
+    error_push (-1, "track %d has no index", track);
+  *start = (off_t) image_track_start (ccd, track) * IMAGE_SECTOR_SIZE;
+  *end = track < ccd->TrackEntries
+    ? (off_t) image_track_start (ccd, track + 1) * IMAGE_SECTOR_SIZE
+    : size;
+
+  /* Do not go beyond the end of the disc image. */
+  if (*start > size) *start = size;
+  if (*end > size) *end = size;
+  if (*end < *start)
+    error_push (-1, "track %d overlaps track %d", track, track + 1);
+
+  /* Return success. */
+  return 0;
+}
+
+static int
+image_silence (FILE *stream, off_t length)
+{
+  static const uint8_t zero[IMAGE_SECTOR_SIZE]; /* A silent sector; */
+
+  while (length > 0)
+    {
+      size_t chunk = length < IMAGE_SECTOR_SIZE ? length : IMAGE_SECTOR_SIZE;
+
+      if (fwrite (zero, 1, chunk, stream) != chunk)
+	error_push_lib (fwrite, -1, "cannot write silence");
+      length -= chunk;
+    }
+
+  /* Return success. */
+  return 0;
+}
+
+static int
+image_silent (const uint8_t *sector)
+{
+  uint64_t acc = 0;		/* All the words ORed together; */
+  int i;			/* Word index; */
+
+  /* OR every word together, without branching, so the loop runs as
+     wide as the target allows. */
+  for (i = 0; i < IMAGE_SECTOR_SIZE; i += sizeof (acc))
+    {
+      uint64_t w;
+      memcpy (&w, sector + i, sizeof (w));
+      acc |= w;
+    }
+
+  return acc == 0;
+}
+
+static void
+image_put_le16 (uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+}
+
+static void
+image_put_le32 (uint8_t *p, uint32_t v)
+{
+  image_put_le16 (p, v & 0xffff);
+  image_put_le16 (p + 2, (v >> 16) & 0xffff);
+}
+
+static int
+image_copy_buffered (FILE *image, off_t offset, off_t length, FILE *stream,
+		     int swap_flag)
+{
+  char *buffer;			/* Copy buffer; */
+
+  /* Go to the beginning of the range. */
+  if (fseeko (image, offset, SEEK_SET) == -1)
+    error_push_lib (fseeko, -1, "cannot copy disc image range");
+
+  buffer = xmalloc (IMAGE_BUFFER_SIZE);
+
+  /* Copy the whole range a buffer at a time. */
+  while (length > 0)
+    {
+      size_t chunk = length < IMAGE_BUFFER_SIZE ? length : IMAGE_BUFFER_SIZE;
+      size_t count = fread (buffer, 1, chunk, image);
+
+      if (swap_flag) swap16 (buffer, count);
+
+      if (count > 0 && fwrite (buffer, 1, count, stream) != count)
+	{
+	  free (buffer);
+	  error_push_lib (fwrite, -1, "cannot copy disc image range");
+	}
+
+      /* Stop at the end of the disc image. */
+      if (count < chunk)
+	{
+	  free (buffer);
+	  if (ferror (image))
+	    error_push_lib (fread, -1, "cannot copy disc image range");
+	  return 0;
+	}
+
+      length -= count;
+    }
+
+  free (buffer);
+
+  /* Return success. */
+  return 0;
+}
@@ -0,0 +1,421 @@
+/*
+ image.h -- Disc image handling;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       image.h
+ * \brief      Disc image handling
+ */
+
+
+#ifndef CCD2CUE_IMAGE_H
+#define CCD2CUE_IMAGE_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "ccd.h"
+#include "cue.h"
+#include "sub.h"
+
+/**
+ * Size of a raw sector in bytes.
+ *
+ * CloneCD always dumps the full 2352 bytes of every sector into the
+ * disc image, regardless of the track mode.
+ *
+ */
+
+#define IMAGE_SECTOR_SIZE 2352
+
+/**
+ * Size of the buffer used to stream disc image data in bytes.
+ *
+ * It is a whole multiple of ::IMAGE_SECTOR_SIZE, so buffered copies
+ * never split a sector.
+ *
+ */
+
+#define IMAGE_BUFFER_SIZE (IMAGE_SECTOR_SIZE * 448)
+
+/**
+ * Size of the RIFF header of a _WAVE_ file in bytes.
+ */
+
+#define IMAGE_WAVE_HEADER_SIZE 44
+
+/**
+ * Number of sectors read by ::image_probe at the beginning of a
+ * track.
+ */
+
+#define IMAGE_PROBE_SECTORS 4
+
+/**
+ * Number of sectors before _INDEX 01_ of a track ::image_gap looks
+ * at, that is 10 seconds.
+ */
+
+#define IMAGE_GAP_WINDOW 750
+
+/**
+ * Minimum number of silent sectors ::image_gap takes as a gap, that
+ * is 1 second.
+ */
+
+#define IMAGE_GAP_MIN 75
+
+/**
+ * Size of a raw sector along with its subchannel data in bytes.
+ */
+
+#define IMAGE_CDG_SECTOR_SIZE (IMAGE_SECTOR_SIZE + SUB_SECTOR_SIZE)
+
+/**
+ * Number of sectors merged at once by ::image_cdg.
+ */
+
+#define IMAGE_CDG_BATCH 448
+
+/**
+ * Get the size of a disc image.
+ *
+ * \param[in]  stream  Disc image stream;
+ *
+ * \return
+ * + >=0  the disc image size in bytes;
+ * + <0   failure;
+ *
+ * \since 0.3
+ *
+ * The size is taken from the file system with 'fstat', so no disc
+ * image data is read.
+ *
+ */
+
+off_t image_size (FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Get the size of a disc image file.
+ *
+ * \param[in]  name  Disc image file name;
+ *
+ * \return
+ * + >=0  the disc image size in bytes;
+ * + <0   failure;
+ *
+ * \since 0.3
+ *
+ * Like ::image_size, but the file is not even opened.
+ *
+ */
+
+off_t image_file_size (const char *name)
+  __attribute__ ((nonnull));
+
+/**
+ * Get the first sector of a track in a disc image.
+ *
+ * \param[in]  ccd    _CCD structure_;
+ * \param[in]  track  Track number;
+ *
+ * \return The first sector of the track, in frames, or -1 if the
+ *         track has no _INDEX_ entry at all.
+ *
+ * \since 0.3
+ *
+ * A track begins at its _INDEX 00_ entry, when there is a pre-gap,
+ * or at its _INDEX 01_ entry otherwise.
+ *
+ */
+
+int image_track_start (const struct ccd *ccd, int track)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Copy a byte range of a disc image to a stream.
+ *
+ * \param[in]   image      Disc image stream;
+ * \param[in]   offset     Offset of the range in bytes;
+ * \param[in]   length     Length of the range in bytes;
+ * \param[out]  stream     Output stream;
+ * \param[in]   swap_flag  Whether to swap the byte order of samples;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * On GNU/Linux the range is carved out with 'copy_file_range', so
+ * file systems supporting reflinks share the blocks and no data
+ * passes through user space.  Whenever that is not possible, or
+ * SWAP_FLAG is true, the range is copied through a buffer of
+ * ::IMAGE_BUFFER_SIZE bytes.  In the latter case the byte order of
+ * every 16 bit sample is swapped with ::swap16 on the way.
+ *
+ * The output stream is flushed before the copy, so any data
+ * previously written to it, like a file header, is preserved.
+ *
+ */
+
+int image_copy (FILE *image, off_t offset, off_t length, FILE *stream,
+		int swap_flag)
+  __attribute__ ((nonnull));
+
+/**
+ * Split a disc image into one file per track.
+ *
+ * \param[in]  ccd         _CCD structure_;
+ * \param[in]  image       Disc image stream;
+ * \param[in]  file_names  Array of output file names indexed by
+ *                         track number;
+ * \param[in]  file_types  Array of output file types indexed by
+ *                         track number;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * Each track spans from its first sector, as given by
+ * ::image_track_start, up to the first sector of the next track.  The
+ * last track spans up to the end of the disc image.
+ *
+ * The way each track file is written depends on its type:
+ *
+ *- _BINARY_: verbatim copy;
+ *- _MOTOROLA_: audio samples byte swapped, as ::image_swap does;
+ *- _WAVE_: RIFF header followed by the samples, as ::image_wave does;
+ *
+ * Any other type is an error.
+ *
+ * \sa
+ * - Parallel step:
+ *   + ::ccd2cue_split
+ *
+ */
+
+int image_split (const struct ccd *ccd, FILE *image, char *const *file_names,
+		 const enum cue_filetype *file_types)
+  __attribute__ ((nonnull));
+
+/**
+ * Write a byte range of a disc image as a _WAVE_ file.
+ *
+ * \param[in]   image   Disc image stream;
+ * \param[in]   offset  Offset of the range in bytes;
+ * \param[in]   length  Length of the range in bytes;
+ * \param[out]  stream  Output stream;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * This function writes a canonical RIFF header of
+ * ::IMAGE_WAVE_HEADER_SIZE bytes, describing 44.1 KHz, 16 bits and
+ * stereo PCM, followed by the raw samples of the range, copied by
+ * ::image_copy.  Audio samples are little endian both in the disc
+ * image and in a _WAVE_ file, so they are not touched.
+ *
+ * A _WAVE_ file cannot hold more than 4 GiB, which is far beyond the
+ * size of any track.
+ *
+ */
+
+int image_wave (FILE *image, off_t offset, off_t length, FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Write a copy of a disc image with audio samples byte swapped.
+ *
+ * \param[in]   ccd     _CCD structure_;
+ * \param[in]   image   Disc image stream;
+ * \param[out]  stream  Output stream;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * CloneCD dumps audio samples in little endian byte order, so a disc
+ * image is of type _BINARY_.  Some burning software gets the byte
+ * order of audio samples wrong with such images, and has to be told
+ * to swap them.  This function writes a copy of the disc image where
+ * the audio tracks are in big endian byte order instead, so it can be
+ * referenced as a file of type _MOTOROLA_.  Data tracks are copied
+ * verbatim, as their byte order is not subject to the file type.
+ *
+ */
+
+int image_swap (const struct ccd *ccd, FILE *image, FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Write a copy of a disc image with subchannel data merged in.
+ *
+ * \param[in]   image   Disc image stream;
+ * \param[in]   sub     Subchannel structure;
+ * \param[out]  stream  Output stream;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * Every sector of ::IMAGE_SECTOR_SIZE bytes of the disc image is
+ * followed by its subchannel data, interleaved by ::sub_interleave,
+ * giving sectors of ::IMAGE_CDG_SECTOR_SIZE bytes, as expected in a
+ * file whose tracks are of type _CDG_.  Sectors beyond the end of the
+ * subchannel data get empty subchannel data.
+ *
+ * The disc image is read ::IMAGE_CDG_BATCH sectors at a time and
+ * each batch is assembled in place, so it is written with a single
+ * call.
+ *
+ */
+
+int image_cdg (FILE *image, const struct sub *sub, FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Write a copy of a disc image with audio samples shifted.
+ *
+ * \param[in]   ccd      _CCD structure_;
+ * \param[in]   image    Disc image stream;
+ * \param[out]  stream   Output stream;
+ * \param[in]   samples  Offset in stereo samples;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * Each run of consecutive audio tracks is shifted as a whole, so the
+ * sample found at position P + SAMPLES of the disc image ends up at
+ * position P of the copy, as if read by a drive whose read offset is
+ * SAMPLES samples greater.  Samples shifted in from beyond the edges
+ * of a run are silence, and those shifted out are lost.  Data tracks
+ * are copied verbatim and the size of the disc image does not change.
+ *
+ * Every range is streamed with ::image_copy, so memory use does not
+ * depend on the size of the disc image.
+ *
+ */
+
+int image_offset (const struct ccd *ccd, FILE *image, FILE *stream,
+		  long samples)
+  __attribute__ ((nonnull));
+
+/**
+ * Tell the mode of a track from its sectors.
+ *
+ * \param[in]  ccd    _CCD structure_;
+ * \param[in]  image  Disc image stream;
+ * \param[in]  track  Track number;
+ *
+ * \return
+ * + >=0  track mode, as in the _MODE_ entry of a _TRACK_ section;
+ * + <0   failure
+ *
+ * \since 0.3
+ *
+ * Up to ::IMAGE_PROBE_SECTORS sectors are read from _INDEX 01_ of the
+ * track on.  A data sector begins with a 12 byte sync pattern and
+ * its header ends with the mode byte, either 1 or 2; any other
+ * sector is taken as audio.  The mode most sectors agree on wins.
+ *
+ */
+
+int image_probe (const struct ccd *ccd, FILE *image, int track)
+  __attribute__ ((nonnull));
+
+/**
+ * Find the gap before a track from its digital silence.
+ *
+ * \param[in]  ccd    _CCD structure_;
+ * \param[in]  image  Disc image stream;
+ * \param[in]  track  Track number;
+ *
+ * \return
+ * + >=0  first sector of the gap, which is _INDEX 01_ of the track if
+ *        there is none;
+ * + <0   failure
+ *
+ * \since 0.3
+ *
+ * The sectors preceding _INDEX 01_ of the track are read backwards,
+ * one second at a time, for as long as they are digital silence,
+ * that is all their samples are zero.  At most ::IMAGE_GAP_WINDOW
+ * sectors are looked at, never reaching _INDEX 01_ of the previous
+ * track.  A run shorter than ::IMAGE_GAP_MIN sectors is taken as the
+ * tail of the previous track rather than as a gap.
+ *
+ * The gap is part of the disc image, so it is meant to become the
+ * _INDEX 00_ entry of the track.
+ *
+ */
+
+int image_gap (const struct ccd *ccd, FILE *image, int track)
+  __attribute__ ((nonnull));
+
+/**
+ * Check a disc image against the layout of its _CCD structure_.
+ *
+ * \param[in]   ccd     _CCD structure_;
+ * \param[in]   size    Disc image size in bytes;
+ * \param[in]   name    Disc image file name;
+ * \param[out]  stream  Output stream;
+ *
+ * \return The number of problems found.
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ * \since 0.3
+ *
+ * A disc image holds every sector up to the lead-out, as given by
+ * ::ccd_leadout, so its size should be exactly the lead-out times
+ * ::IMAGE_SECTOR_SIZE.  A line of tab separated fields is written to
+ * STREAM with NAME, the status, the lead-out in sectors, or -1, and
+ * SIZE.  The status is one of:
+ *
+ *- _ok_: the size matches;
+ *- _truncated_: the disc image is smaller;
+ *- _oversized_: the disc image is larger;
+ *- _noleadout_: the TOC has no lead-out to check against;
+ *
+ * Then a line with NAME, _index_, the track number, the index number
+ * and the sector is written for every _INDEX_ entry out of the disc
+ * image.  Each line besides an _ok_ one is a problem.
+ *
+ * Only SIZE is looked at, so no disc image data is read.
+ *
+ */
+
+int image_check (const struct ccd *ccd, off_t size, const char *name,
+		 FILE *stream)
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_IMAGE_H */
@@ -0,0 +1,135 @@
+/*
+ sha1.c -- Secure Hash Algorithm 1;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       sha1.c
+ * \brief      Secure Hash Algorithm 1
+ */
+
+
+#include "config.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "sha1.h"
+
+
+/** Size of a SHA-1 block in bytes; */
+#define SHA1_BLOCK_SIZE 64
+
+/** Rotate a 32 bit word left by N bits; */
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+
+/**
+ * Process a single block of a message.
+ *
+ * \param[in,out]  h      Intermediate hash value;
+ * \param[in]      block  Block of ::SHA1_BLOCK_SIZE bytes;
+ *
+ * \since 0.3
+ *
+ */
+
+static void sha1_block (uint32_t h[5], const uint8_t *block)
+  __attribute__ ((nonnull));
+
+
+void
+sha1 (const void *message, size_t length, uint8_t digest[SHA1_DIGEST_SIZE])
+{
+  uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+		   0xc3d2e1f0};	/* Hash value; */
+  uint8_t last[2 * SHA1_BLOCK_SIZE]; /* Padded final blocks; */
+  const uint8_t *p = message;	/* Current block; */
+  size_t rest;			/* Bytes left for the final blocks; */
+  size_t pad;			/* Size of the final blocks; */
+  uint64_t bits = (uint64_t) length * 8; /* Message length in bits; */
+  int i;			/* Byte index; */
+
+  /* Assert the message pointer is valid. */
+  assert (message != NULL);
+
+  /* Assert the digest pointer is valid. */
+  assert (digest != NULL);
+
+  /* Process all whole blocks in place. */
+  for (; length >= SHA1_BLOCK_SIZE; length -= SHA1_BLOCK_SIZE)
+    {
+      sha1_block (h, p);
+      p += SHA1_BLOCK_SIZE;
+    }
+
+  /* Pad the remainder with a one bit, zeros and the message length
+     in bits, most significant byte first, into one or two blocks. */
+  rest = length;
+  pad = rest + 1 + 8 <= SHA1_BLOCK_SIZE ? SHA1_BLOCK_SIZE : 2 * SHA1_BLOCK_SIZE;
+  memset (last, 0, sizeof (last));
+  memcpy (last, p, rest);
+  last[rest] = 0x80;
+  for (i = 0; i < 8; i++)
+    last[pad - 1 - i] = (bits >> (8 * i)) & 0xff;
+
+  sha1_block (h, last);
+  if (pad > SHA1_BLOCK_SIZE) sha1_block (h, last + SHA1_BLOCK_SIZE);
+
+  /* The digest is the hash value, most significant byte first. */
+  for (i = 0; i < SHA1_DIGEST_SIZE; i++)
+    digest[i] = (h[i / 4] >> (24 - 8 * (i % 4))) & 0xff;
+}
+
+static void
+sha1_block (uint32_t h[5], const uint8_t *block)
+{
+  uint32_t w[80];		/* Message schedule; */
+  uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4]; /* Working
+								variables; */
+  int t;			/* Round; */
+
+  for (t = 0; t < 16; t++)
+    w[t] = (uint32_t) block[4 * t] << 24 | (uint32_t) block[4 * t + 1] << 16
+      | (uint32_t) block[4 * t + 2] << 8 | block[4 * t + 3];
+  for (; t < 80; t++)
+    w[t] = ROL32 (w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+
+  for (t = 0; t < 80; t++)
+    {
+      uint32_t f, k, temp;	/* Round function, constant and sum; */
+
+      if (t < 20) f = (b & c) | (~b & d), k = 0x5a827999;
+      else if (t < 40) f = b ^ c ^ d, k = 0x6ed9eba1;
+      else if (t < 60) f = (b & c) | (b & d) | (c & d), k = 0x8f1bbcdc;
+      else f = b ^ c ^ d, k = 0xca62c1d6;
+
+      temp = ROL32 (a, 5) + f + e + k + w[t];
+      e = d;
+      d = c;
+      c = ROL32 (b, 30);
+      b = a;
+      a = temp;
+    }
+
+  h[0] += a;
+  h[1] += b;
+  h[2] += c;
+  h[3] += d;
+  h[4] += e;
+}
@@ -0,0 +1,59 @@
+/*
+ sha1.h -- Secure Hash Algorithm 1;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       sha1.h
+ * \brief      Secure Hash Algorithm 1
+ */
+
+
+#ifndef CCD2CUE_SHA1_H
+#define CCD2CUE_SHA1_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Size of a SHA-1 digest in bytes.
+ */
+
+#define SHA1_DIGEST_SIZE 20
+
+/**
+ * Calculate the SHA-1 digest of a message.
+ *
+ * \param[in]   message  A pointer to the message.
+ * \param[in]   length   The length of the message in bytes.
+ * \param[out]  digest   The digest, ::SHA1_DIGEST_SIZE bytes long.
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * This function implements SHA-1 as specified in FIPS 180-4.  It is
+ * used to calculate MusicBrainz disc IDs in ::ccd2discid, where it
+ * serves as a fingerprint rather than for security.
+ *
+ */
+
+void sha1 (const void *message, size_t length,
+	   uint8_t digest[SHA1_DIGEST_SIZE])
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_SHA1_H */
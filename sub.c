@@ -0,0 +1,345 @@
+/*
+ sub.c -- Subchannel format structure;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       sub.c
+ * \brief      Subchannel format structure
+ */
+
+
+#include "config.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/types.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "memory.h"
+#include "io.h"
+#include "errors.h"
+#include "crc.h"
+#include "sub.h"
+
+
+/**
+ * Deinterleave the raw subchannel data of a single sector.
+ *
+ * \param[in]   raw     Raw subchannel data of the sector;
+ * \param[out]  sector  Sector;
+ *
+ * \since 0.3
+ *
+ * \sa ::sub_deinterleave
+ *
+ */
+
+static void sub_deinterleave_sector (const uint8_t *raw,
+				     struct sub_sector *sector)
+  __attribute__ ((nonnull));
+
+/**
+ * Transpose an 8x8 bit matrix.
+ *
+ * \param[in]  x  Matrix, one row per byte, the first row in the most
+ *                significant byte and the first column in the most
+ *                significant bit of each row;
+ *
+ * \return The transposed matrix.
+ *
+ * \since 0.3
+ *
+ * Transposition is its own inverse, so this turns 8 raw bytes into 1
+ * byte of each plane, as well as the other way around.
+ *
+ */
+
+static uint64_t sub_transpose (uint64_t x)
+  __attribute__ ((const));
+
+
+void
+sub_deinterleave (const void *raw, struct sub_sector *sector, size_t count)
+{
+  const uint8_t *p = raw;	/* Current raw sector; */
+  size_t i;			/* Sector index; */
+
+  /* Assert the raw data is valid. */
+  assert (raw != NULL);
+
+  /* Assert the sector array is valid. */
+  assert (sector != NULL);
+
+  for (i = 0; i < count; i++, p += SUB_SECTOR_SIZE)
+    sub_deinterleave_sector (p, &sector[i]);
+}
+
+void
+sub_interleave (const struct sub_sector *sector, void *raw, size_t count)
+{
+  uint8_t *p = raw;		/* Current raw sector; */
+  size_t i;			/* Sector index; */
+
+  /* Assert the sector array is valid. */
+  assert (sector != NULL);
+
+  /* Assert the raw data is valid. */
+  assert (raw != NULL);
+
+  for (i = 0; i < count; i++, p += SUB_SECTOR_SIZE)
+    {
+      int k;			/* Byte offset inside each plane; */
+
+      /* Transpose 1 byte of each plane, that is 8 raw bytes, at a
+	 time. */
+      for (k = 0; k < SUB_CHANNEL_SIZE; k++)
+	{
+	  uint64_t x = 0;
+	  int c;
+
+	  for (c = SUB_P; c <= SUB_W; c++)
+	    x = (x << 8) | sector[i].channel[c][k];
+
+	  x = sub_transpose (x);
+
+	  for (c = 0; c < 8; c++)
+	    p[8 * k + c] = (x >> (56 - 8 * c)) & 0xff;
+	}
+    }
+}
+
+size_t
+sub_cdg_packs (const struct sub *sub, size_t first, size_t last)
+{
+  size_t packs = 0;		/* CD+G packs found; */
+  size_t i;			/* Sector index; */
+
+  /* Assert the subchannel structure is valid. */
+  assert (sub != NULL);
+
+  if (last > sub->sectors) last = sub->sectors;
+
+  for (i = first; i < last; i++)
+    {
+      int j;			/* Pack index; */
+
+      /* The first symbol of each of the 4 packs of a sector tells its
+	 mode and item. */
+      for (j = 0; j < SUB_PACKS; j++)
+	{
+	  int bit = j * SUB_PACK_SYMBOLS; /* Bit offset of the symbol
+					     inside each plane; */
+	  int symbol = 0;	/* 6 bit symbol made of R to W; */
+	  int c;		/* Subchannel; */
+
+	  for (c = SUB_R; c <= SUB_W; c++)
+	    symbol = (symbol << 1)
+	      | ((sub->sector[i].channel[c][bit / 8] >> (7 - bit % 8)) & 1);
+
+	  if (symbol == SUB_CDG_MODE) packs++;
+	}
+    }
+
+  return packs;
+}
+
+int
+sub_q_check (const struct sub_sector *sector)
+{
+  const uint8_t *q = sector->channel[SUB_Q]; /* Q subchannel; */
+  uint16_t crc = crc16 (q, SUB_CHANNEL_SIZE - 2);
+
+  return q[SUB_CHANNEL_SIZE - 2] == ((crc >> 8) & 0xff)
+    && q[SUB_CHANNEL_SIZE - 1] == (crc & 0xff);
+}
+
+int
+sub_interleaved (FILE *stream)
+{
+  uint8_t raw[SUB_SECTOR_SIZE * SUB_PROBE_SECTORS]; /* Raw data read; */
+  struct sub_sector sector[SUB_PROBE_SECTORS]; /* Deinterleaved data; */
+  int stored = 0, deinterleaved = 0; /* Sectors passing each check; */
+  off_t offset;			/* Position of the stream; */
+  size_t count;			/* Sectors read; */
+  size_t i;			/* Sector index; */
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  offset = ftello (stream);
+  if (offset == -1)
+    error_push_lib (ftello, -1, "cannot probe subchannel stream");
+
+  count = fread (raw, SUB_SECTOR_SIZE, SUB_PROBE_SECTORS, stream);
+  if (ferror (stream))
+    error_push_lib (fread, -1, "cannot probe subchannel stream");
+
+  if (fseeko (stream, offset, SEEK_SET) == -1)
+    error_push_lib (fseeko, -1, "cannot probe subchannel stream");
+
+  memcpy (sector, raw, SUB_SECTOR_SIZE * count);
+  for (i = 0; i < count; i++)
+    stored += sub_q_check (&sector[i]);
+
+  sub_deinterleave (raw, sector, count);
+  for (i = 0; i < count; i++)
+    deinterleaved += sub_q_check (&sector[i]);
+
+  return deinterleaved > stored;
+}
+
+int
+stream2sub (FILE *stream, struct sub *sub, int interleaved_flag)
+{
+  size_t allocated = 0;		/* Sectors allocated in SUB; */
+  uint8_t *buffer = NULL;	/* Raw data buffer; */
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  /* Assert the subchannel structure is valid. */
+  assert (sub != NULL);
+
+  /* Initialize the subchannel structure. */
+  sub->sector = NULL;
+  sub->sectors = 0;
+
+  /* Raw data needs to be read aside to be deinterleaved. */
+  if (interleaved_flag)
+    buffer = xmalloc (SUB_SECTOR_SIZE * SUB_BUFFER_SECTORS);
+
+  /* Parse the whole stream. */
+  for (;;)
+    {
+      size_t count;		/* Sectors read; */
+
+      /* Make room for one more chunk, growing geometrically. */
+      if (allocated - sub->sectors < SUB_BUFFER_SECTORS)
+	{
+	  allocated = allocated ? allocated * 2 : SUB_BUFFER_SECTORS;
+	  sub->sector = xrealloc (sub->sector, sizeof (*sub->sector) * allocated);
+	}
+
+      /* Read the chunk, straight into place when it needs no
+	 processing. */
+      if (interleaved_flag)
+	{
+	  count = fread (buffer, SUB_SECTOR_SIZE, SUB_BUFFER_SECTORS, stream);
+	  sub_deinterleave (buffer, &sub->sector[sub->sectors], count);
+	}
+      else
+	count = fread (&sub->sector[sub->sectors], SUB_SECTOR_SIZE,
+		       SUB_BUFFER_SECTORS, stream);
+
+      sub->sectors += count;
+
+      /* Stop at the end of the stream. */
+      if (count < SUB_BUFFER_SECTORS) break;
+    }
+
+  free (buffer);
+
+  if (ferror (stream))
+    error_push_lib (fread, -1, "cannot parse subchannel stream");
+
+  /* Return success. */
+  return 0;
+}
+
+void
+sub2stream (const struct sub *sub, FILE *stream)
+{
+  /* Assert the subchannel structure is valid. */
+  assert (sub != NULL);
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  /* The structure already has the stream layout. */
+  if (sub->sectors > 0)
+    xfwrite (sub->sector, sizeof (*sub->sector), sub->sectors, stream);
+}
+
+static void
+sub_deinterleave_sector (const uint8_t *raw, struct sub_sector *sector)
+{
+  int k = 0;			/* Byte offset inside each plane; */
+  int c;			/* Subchannel; */
+
+#ifdef __SSE2__
+  /* Transpose 16 raw bytes, that is 2 bytes of each plane, at a
+     time.  The first raw byte of each group of 8 must end up as the
+     most significant bit of a plane byte, but byte mask extraction
+     puts it in the least significant one, so first reverse the order
+     of the bytes inside each half.  Then, for each subchannel, shift
+     its bit into the sign position of every byte and extract it. */
+  for (; k < SUB_CHANNEL_SIZE; k += 2)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (raw + 8 * k));
+      v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+      v = _mm_shufflelo_epi16 (v, _MM_SHUFFLE (0, 1, 2, 3));
+      v = _mm_shufflehi_epi16 (v, _MM_SHUFFLE (0, 1, 2, 3));
+
+      for (c = SUB_P; c <= SUB_W; c++)
+	{
+	  int mask = _mm_movemask_epi8 (_mm_slli_epi16 (v, c));
+	  sector->channel[c][k] = mask & 0xff;
+	  sector->channel[c][k + 1] = (mask >> 8) & 0xff;
+	}
+    }
+#endif
+
+  /* Transpose 8 raw bytes, that is 1 byte of each plane, at a time
+     as an 8x8 bit matrix. */
+  for (; k < SUB_CHANNEL_SIZE; k++)
+    {
+      uint64_t x = 0;
+      int i;
+
+      for (i = 0; i < 8; i++)
+	x = (x << 8) | raw[8 * k + i];
+
+      x = sub_transpose (x);
+
+      for (c = SUB_P; c <= SUB_W; c++)
+	sector->channel[c][k] = (x >> (56 - 8 * c)) & 0xff;
+    }
+}
+
+static uint64_t
+sub_transpose (uint64_t x)
+{
+  /* Swap bits, then bit pairs, then nibbles across the diagonal. */
+  x = (x & UINT64_C (0xaa55aa55aa55aa55))
+    | ((x & UINT64_C (0x00aa00aa00aa00aa)) << 7)
+    | ((x >> 7) & UINT64_C (0x00aa00aa00aa00aa));
+  x = (x & UINT64_C (0xcccc3333cccc3333))
+    | ((x & UINT64_C (0x0000cccc0000cccc)) << 14)
+    | ((x >> 14) & UINT64_C (0x0000cccc0000cccc));
+  x = (x & UINT64_C (0xf0f0f0f00f0f0f0f))
+    | ((x & UINT64_C (0x00000000f0f0f0f0)) << 28)
+    | ((x >> 28) & UINT64_C (0x00000000f0f0f0f0));
+
+  return x;
+}
@@ -0,0 +1,308 @@
+/*
+ sub.h -- Subchannel format structure;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       sub.h
+ * \brief      Subchannel format structure
+ */
+
+
+#ifndef CCD2CUE_SUB_H
+#define CCD2CUE_SUB_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Size of the subchannel data of a sector in bytes.
+ */
+
+#define SUB_SECTOR_SIZE 96
+
+/**
+ * Size of a single subchannel of a sector in bytes.
+ */
+
+#define SUB_CHANNEL_SIZE 12
+
+/**
+ * Number of sectors read at once by ::stream2sub.
+ */
+
+#define SUB_BUFFER_SECTORS 8192
+
+/**
+ * Number of sectors ::sub_interleaved looks at, one second of audio.
+ */
+
+#define SUB_PROBE_SECTORS 75
+
+/**
+ * Number of packs carried by the R to W subchannels of a sector.
+ */
+
+#define SUB_PACKS 4
+
+/**
+ * Number of 6 bit symbols of a pack.
+ */
+
+#define SUB_PACK_SYMBOLS 24
+
+/**
+ * Mode and item of CD+G packs.
+ *
+ * The first symbol of a pack holds its mode in the upper 3 bits and
+ * its item in the lower 3 bits.  CD+G graphics are mode 1, item 1.
+ *
+ */
+
+#define SUB_CDG_MODE 0x09
+
+/**
+ * Subchannels
+ *
+ * Every sector carries 8 subchannels, named P to W, of 96 bits each.
+ * The P channel flags pauses, the Q channel carries positioning, MCN
+ * and ISRC data, and the R to W channels carry CD-Text in the
+ * lead-in or graphics, like CD+G, in the program area.
+ *
+ */
+
+enum sub_channel
+  {
+    SUB_P,			/**< Pause flag. */
+    SUB_Q,			/**< Control, address and data. */
+    SUB_R,			/**< User data. */
+    SUB_S,			/**< User data. */
+    SUB_T,			/**< User data. */
+    SUB_U,			/**< User data. */
+    SUB_V,			/**< User data. */
+    SUB_W			/**< User data. */
+  };
+
+/**
+ * Subchannel data of a sector
+ *
+ * The subchannels are stored one after another, each one in its own
+ * plane of ::SUB_CHANNEL_SIZE bytes, most significant bit first.
+ * This is exactly the layout of a sector in a CloneCD ".sub" file.
+ *
+ */
+
+struct sub_sector
+{
+  uint8_t channel[8][SUB_CHANNEL_SIZE]; /**< Subchannel planes indexed
+					   by ::sub_channel. */
+};
+
+/**
+ * Subchannel format structure
+ *
+ * This structure holds the subchannel data of every sector of a disc
+ * image, as found in the ".sub" file accompanying a _CCD sheet_.  It
+ * is filled out by ::stream2sub.
+ *
+ */
+
+struct sub
+{
+  struct sub_sector *sector;	/**< Array of sectors. */
+  size_t sectors;		/**< Number of sectors. */
+};
+
+/**
+ * Q subchannel modes
+ *
+ * The lower nibble of the first byte of the Q subchannel, called ADR,
+ * tells what kind of data the remainder carries.
+ *
+ */
+
+enum sub_q_adr
+  {
+    SUB_Q_POSITION = 1,		/**< Track, index and time. */
+    SUB_Q_MCN = 2,		/**< Media Catalog Number. */
+    SUB_Q_ISRC = 3		/**< International Standard Recording
+				   Code. */
+  };
+
+/**
+ * Check the CRC of the Q subchannel of a sector.
+ *
+ * \param[in]  sector  Sector;
+ *
+ * \return
+ * + !=0  the CRC matches;
+ * + =0   the CRC does not match;
+ *
+ * \since 0.3
+ *
+ * The last 2 bytes of the Q subchannel hold the negated CRC-16, with
+ * a normal polynomial CCITT, of the first 10 bytes, most significant
+ * byte first.  It is the same checksum ::crc16 calculates for
+ * _CD-Text_ entries.
+ *
+ */
+
+int sub_q_check (const struct sub_sector *sector)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Deinterleave raw subchannel data.
+ *
+ * \param[in]   raw      Raw subchannel data of COUNT sectors;
+ * \param[out]  sector   Array of COUNT sectors;
+ * \param[in]   count    Number of sectors;
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * As read from a drive, the raw subchannel data of a sector is a
+ * sequence of 96 bytes where each byte carries one bit of every
+ * subchannel: P in the most significant bit down to W in the least
+ * significant one.  This function transposes those bits into one
+ * plane per subchannel, as in ::sub_sector.
+ *
+ * Where SSE2 is available, 16 bytes are transposed at once by means
+ * of byte mask extraction; elsewhere 8 bytes are transposed at once
+ * as an 8x8 bit matrix within a 64 bit word.
+ *
+ */
+
+void sub_deinterleave (const void *raw, struct sub_sector *sector,
+		       size_t count)
+  __attribute__ ((nonnull));
+
+/**
+ * Interleave subchannel data.
+ *
+ * \param[in]   sector   Array of COUNT sectors;
+ * \param[out]  raw      Raw subchannel data of COUNT sectors;
+ * \param[in]   count    Number of sectors;
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * This is the inverse of ::sub_deinterleave, giving the layout raw
+ * sectors of 2448 bytes carry after their 2352 bytes of main data.
+ *
+ */
+
+void sub_interleave (const struct sub_sector *sector, void *raw,
+		     size_t count)
+  __attribute__ ((nonnull));
+
+/**
+ * Count CD+G packs in a range of sectors.
+ *
+ * \param[in]  sub    Subchannel structure;
+ * \param[in]  first  First sector of the range;
+ * \param[in]  last   Sector following the last one of the range;
+ *
+ * \return The number of packs whose mode and item are
+ *         ::SUB_CDG_MODE.
+ *
+ * \since 0.3
+ *
+ * Each sector carries ::SUB_PACKS packs in the R to W subchannels.
+ * Sectors beyond the end of the subchannel data are not counted.
+ *
+ */
+
+size_t sub_cdg_packs (const struct sub *sub, size_t first, size_t last)
+  __attribute__ ((nonnull, pure));
+
+/**
+ * Tell whether a subchannel stream holds raw, interleaved, data.
+ *
+ * \param[in]  stream  Input stream, positioned at its first sector;
+ *
+ * \return
+ * + >0  interleaved
+ * + =0  deinterleaved
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * Both layouts are 96 bytes per sector, so the first
+ * ::SUB_PROBE_SECTORS sectors are checked with ::sub_q_check as
+ * stored and once deinterleaved, and the layout under which more of
+ * them pass is taken, CloneCD ".sub" files on a tie.  The stream is
+ * put back where it was, ready for ::stream2sub.
+ *
+ */
+
+int sub_interleaved (FILE *stream)
+  __attribute__ ((nonnull));
+
+/**
+ * Parse a subchannel stream into a subchannel structure.
+ *
+ * \param[in]   stream            Input stream;
+ * \param[out]  sub               Uninitialized subchannel structure
+ *                                to fill out;
+ * \param[in]   interleaved_flag  Whether the stream holds raw,
+ *                                interleaved, subchannel data;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \since 0.3
+ *
+ * CloneCD ".sub" files are already deinterleaved, so their sectors
+ * are read straight into the structure.  Raw subchannel data, as
+ * told by ::sub_interleaved, is deinterleaved with
+ * ::sub_deinterleave on the way.  Either way the
+ * stream is read ::SUB_BUFFER_SECTORS sectors at a time.
+ *
+ * A trailing partial sector is ignored.
+ *
+ */
+
+int stream2sub (FILE *stream, struct sub *sub, int interleaved_flag)
+  __attribute__ ((nonnull));
+
+/**
+ * Convert a subchannel structure into a subchannel stream.
+ *
+ * \param[in]   sub     Subchannel structure;
+ * \param[out]  stream  Output stream;
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ * \since 0.3
+ *
+ * The stream is written in the deinterleaved layout of CloneCD
+ * ".sub" files, ::SUB_SECTOR_SIZE bytes per sector, in one go.
+ *
+ * \sa
+ * - Previous step:
+ *   + ::ccd2sub
+ *
+ */
+
+void sub2stream (const struct sub *sub, FILE *stream)
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_SUB_H */
@@ -0,0 +1,77 @@
+/*
+ swap.c -- Byte order swapping;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       swap.c
+ * \brief      Byte order swapping
+ */
+
+
+#include "config.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "swap.h"
+
+
+void
+swap16 (void *buffer, size_t length)
+{
+  uint8_t *p = buffer;		/* Current position in the buffer; */
+  uint8_t *end = p + (length & ~(size_t) 1); /* End of the last whole
+						sample; */
+
+  /* Assert the buffer is valid. */
+  assert (buffer != NULL);
+
+#ifdef __SSE2__
+  /* Swap 8 samples at a time by shifting each 16 bit lane both
+     ways. */
+  for (; end - p >= 16; p += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) p);
+      v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+      _mm_storeu_si128 ((__m128i *) p, v);
+    }
+#endif
+
+  /* Swap 4 samples at a time within a 64 bit word. */
+  for (; end - p >= 8; p += 8)
+    {
+      uint64_t w;
+      memcpy (&w, p, sizeof (w));
+      w = ((w & UINT64_C (0x00ff00ff00ff00ff)) << 8)
+	| ((w >> 8) & UINT64_C (0x00ff00ff00ff00ff));
+      memcpy (p, &w, sizeof (w));
+    }
+
+  /* Swap the remaining samples one by one. */
+  for (; p < end; p += 2)
+    {
+      uint8_t t = p[0];
+      p[0] = p[1];
+      p[1] = t;
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ swap.h -- Byte order swapping;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       swap.h
+ * \brief      Byte order swapping
+ */
+
+
+#ifndef CCD2CUE_SWAP_H
+#define CCD2CUE_SWAP_H
+
+#include <stddef.h>
+
+/**
+ * Swap the byte order of 16 bit samples in place.
+ *
+ * \param[in,out]  buffer  A pointer to the samples.
+ * \param[in]      length  The length of the buffer in bytes.
+ *
+ * \note This function never raises an error.
+ *
+ * \since 0.3
+ *
+ * This function turns little endian 16 bit samples, as found in the
+ * audio tracks of a disc image of type _BINARY_, into big endian
+ * ones, as expected in a disc image of type _MOTOROLA_, and vice
+ * versa.  If LENGTH is odd, the last byte is left untouched.
+ *
+ * Where SSE2 is available, 8 samples are swapped at once; elsewhere
+ * 4 samples are swapped at once within a 64 bit word.
+ *
+ * \sa ::cue_filetype
+ *
+ */
+
+void swap16 (void *buffer, size_t length)
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_SWAP_H */
@@ -0,0 +1,400 @@
+/*
+ toc.c -- cdrdao TOC file format;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       toc.c
+ * \brief      cdrdao TOC file format
+ */
+
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+#include "memory.h"
+#include "errors.h"
+#include "io.h"
+#include "ccd.h"
+#include "cue.h"
+#include "image.h"
+#include "toc.h"
+
+
+/**
+ * Output buffer
+ *
+ * The _TOC file_ is formatted into this buffer, which grows
+ * geometrically, and then written in one go.
+ *
+ */
+
+struct toc_buffer
+{
+  char *data;			/**< Formatted text. */
+  size_t length;		/**< Length of the text. */
+  size_t size;			/**< Size of DATA. */
+};
+
+/**
+ * Track modes strings
+ *
+ * This array associates the ::cue_datatype enumeration with the track
+ * modes of cdrdao.  _CD+G_ has none.
+ *
+ */
+
+static const char *mode[] =
+  { [AUDIO_2352] "AUDIO",
+    [CDG_2448] NULL,
+    [MODE1_2048] "MODE1",
+    [MODE1_2352] "MODE1_RAW",
+    [MODE2_2336] "MODE2",
+    [MODE2_2352] "MODE2_RAW",
+    [CDI_2336] "MODE2",
+    [CDI_2352] "MODE2_RAW" };
+
+/**
+ * Sector sizes
+ *
+ * This array associates the ::cue_datatype enumeration with the size
+ * of a sector in the file, in bytes.
+ *
+ */
+
+static const int sector_size[] =
+  { [AUDIO_2352] 2352,
+    [CDG_2448] 2448,
+    [MODE1_2048] 2048,
+    [MODE1_2352] 2352,
+    [MODE2_2336] 2336,
+    [MODE2_2352] 2352,
+    [CDI_2336] 2336,
+    [CDI_2352] 2352 };
+
+
+/**
+ * Format text at the end of an output buffer.
+ *
+ * \param[in,out]  buffer    Output buffer;
+ * \param[in]      template  Format template, as for printf;
+ *
+ * \since 0.3
+ *
+ */
+
+static void toc_printf (struct toc_buffer *buffer, const char *template, ...)
+  __attribute__ ((nonnull, format (printf, 2, 3)));
+
+/**
+ * Append a quoted string to an output buffer.
+ *
+ * \param[in,out]  buffer  Output buffer;
+ * \param[in]      string  String;
+ *
+ * \since 0.3
+ *
+ * Quotes and backslashes are escaped with a backslash, and the
+ * string is truncated to 80 characters, as in a _CUE sheet_.
+ *
+ */
+
+static void toc_quote (struct toc_buffer *buffer, const char *string)
+  __attribute__ ((nonnull));
+
+/**
+ * Append a _CD_TEXT_ block to an output buffer.
+ *
+ * \param[in,out]  buffer      Output buffer;
+ * \param[in]      map_flag    Whether to add the language map, as the
+ *                             block of the disc needs;
+ * \param[in]      title       _TITLE_ entry, or NULL;
+ * \param[in]      performer   _PERFORMER_ entry, or NULL;
+ * \param[in]      songwriter  _SONGWRITER_ entry, or NULL;
+ *
+ * \since 0.3
+ *
+ */
+
+static void toc_cd_text (struct toc_buffer *buffer, int map_flag,
+			 const char *title, const char *performer,
+			 const char *songwriter)
+  __attribute__ ((nonnull (1)));
+
+/**
+ * Format a time as _MSF_.
+ *
+ * \param[in]  frames  Time in frames;
+ *
+ * \return The time in the form "mm:ss:ff", in a static buffer.
+ *
+ * \since 0.3
+ *
+ */
+
+static const char *toc_msf (long frames);
+
+
+int
+toc2stream (const struct cue *cue, const struct ccd *ccd, FILE *stream)
+{
+  struct toc_buffer buffer = { NULL, 0, 0 }; /* Output buffer; */
+  int data = 0, mode2 = 0;	/* Data and mode 2 tracks; */
+  int swap_flag = 0;		/* Whether any audio is little endian; */
+  int text_flag;		/* Whether there is any text; */
+  long leadout;			/* Lead-out; */
+  int f;			/* FILE index; */
+
+  /* Assert the CUE structure is valid. */
+  assert (cue != NULL);
+
+  /* Assert the CCD structure is valid. */
+  assert (ccd != NULL);
+
+  /* Assert the stream is valid. */
+  assert (stream != NULL);
+
+  leadout = ccd_leadout (ccd);
+  text_flag = cue->TITLE || cue->PERFORMER || cue->SONGWRITER;
+
+  /* Survey the tracks for the disc type and text. */
+  for (f = 0; f < cue->FileEntries; f++)
+    {
+      const struct cue_FILE *file = &cue->FILE[f]; /* FILE entry; */
+      int t;			/* Track number; */
+
+      for (t = file->FirstTrack; file->TRACK != NULL && t <= file->TrackEntries;
+	   t++)
+	{
+	  const struct cue_TRACK *track = &file->TRACK[t]; /* TRACK entry; */
+
+	  if (mode[track->datatype] == NULL)
+	    error_push (-1, "track %d cannot be described in a TOC file", t);
+
+	  if (track->datatype != AUDIO_2352) data++;
+	  else if (file->filetype == BINARY) swap_flag = 1;
+
+	  if (track->datatype >= MODE2_2336) mode2++;
+
+	  if (track->TITLE || track->PERFORMER || track->SONGWRITER)
+	    text_flag = 1;
+	}
+    }
+
+  buffer.size = TOC_BUFFER_SIZE;
+  buffer.data = xmalloc (buffer.size);
+
+  if (swap_flag)
+    toc_printf (&buffer, "// Audio samples are little endian: "
+		"write with 'cdrdao write --swap'.\n\n");
+
+  /* Disc type. */
+  if (data == 0)
+    toc_printf (&buffer, "CD_DA\n");
+  else if (ccd_disc_type (ccd) == CCD_DISC_CDI)
+    toc_printf (&buffer, "CD_I\n");
+  else if (mode2 > 0 || ccd_disc_type (ccd) == CCD_DISC_XA)
+    toc_printf (&buffer, "CD_ROM_XA\n");
+  else
+    toc_printf (&buffer, "CD_ROM\n");
+
+  if (cue->CATALOG[0] != '\0')
+    toc_printf (&buffer, "CATALOG \"%.13s\"\n", cue->CATALOG);
+
+  /* Track blocks need the disc block, which maps the languages. */
+  if (text_flag)
+    toc_cd_text (&buffer, 1, cue->TITLE, cue->PERFORMER, cue->SONGWRITER);
+
+  for (f = 0; f < cue->FileEntries; f++)
+    {
+      const struct cue_FILE *file = &cue->FILE[f]; /* FILE entry; */
+      int t;			/* Track number; */
+
+      for (t = file->FirstTrack; file->TRACK != NULL && t <= file->TrackEntries;
+	   t++)
+	{
+	  const struct cue_TRACK *track = &file->TRACK[t]; /* TRACK entry; */
+	  long index[100];	/* INDEX entries in frames, or -1; */
+	  long start, length = -1; /* Track range in the file; */
+	  int j;		/* INDEX index; */
+
+	  for (j = 0; j < 100; j++)
+	    index[j] = j < track->IndexEntries && track->INDEX[j].initialized
+	      ? (long) ((track->INDEX[j].minutes * 60 + track->INDEX[j].seconds)
+			* 75 + track->INDEX[j].frames)
+	      : -1;
+
+	  if (index[1] < 0)
+	    {
+	      free (buffer.data);
+	      error_push (-1, "track %d has no INDEX 01", t);
+	    }
+
+	  /* The track spans from its pre-gap, if any, to the next
+	     track or the lead-out, as the CCD structure tells. */
+	  start = index[0] >= 0 ? index[0] : index[1];
+	  if (t <= ccd->TrackEntries)
+	    {
+	      long end = t < ccd->TrackEntries
+		? image_track_start (ccd, t + 1) : leadout;
+
+	      if (end >= 0 && image_track_start (ccd, t) >= 0)
+		length = end - image_track_start (ccd, t);
+	    }
+
+	  toc_printf (&buffer, "\n// Track %d\nTRACK %s\n", t,
+		      mode[track->datatype]);
+
+	  /* Flags. */
+	  if (track->FLAGS != NULL && strstr (track->FLAGS, "DCP") != NULL)
+	    toc_printf (&buffer, "COPY\n");
+	  if (track->datatype == AUDIO_2352 && track->FLAGS != NULL)
+	    {
+	      if (strstr (track->FLAGS, "PRE") != NULL)
+		toc_printf (&buffer, "PRE_EMPHASIS\n");
+	      if (strstr (track->FLAGS, "4CH") != NULL)
+		toc_printf (&buffer, "FOUR_CHANNEL_AUDIO\n");
+	    }
+
+	  if (track->ISRC[0] != '\0')
+	    toc_printf (&buffer, "ISRC \"%.12s\"\n", track->ISRC);
+
+	  if (track->TITLE || track->PERFORMER || track->SONGWRITER)
+	    toc_cd_text (&buffer, 0, track->TITLE, track->PERFORMER,
+			 track->SONGWRITER);
+
+	  /* Audio is addressed in time, data in bytes. */
+	  if (track->datatype == AUDIO_2352)
+	    {
+	      toc_printf (&buffer, "AUDIOFILE ");
+	      toc_quote (&buffer, file->filename);
+	      toc_printf (&buffer, " %s", toc_msf (start));
+	    }
+	  else
+	    {
+	      toc_printf (&buffer, "DATAFILE ");
+	      toc_quote (&buffer, file->filename);
+	      toc_printf (&buffer, " #%ld", start * sector_size[track->datatype]);
+	    }
+	  if (length >= 0)
+	    toc_printf (&buffer, " %s", toc_msf (length));
+	  toc_printf (&buffer, "\n");
+
+	  /* The pre-gap is part of the data; the indexes count from
+	     its end. */
+	  if (index[0] >= 0)
+	    toc_printf (&buffer, "START %s\n", toc_msf (index[1] - index[0]));
+	  for (j = 2; j < 100; j++)
+	    if (index[j] >= 0)
+	      toc_printf (&buffer, "INDEX %s\n", toc_msf (index[j] - index[1]));
+	}
+    }
+
+  /* Write the whole file at once. */
+  xfwrite (buffer.data, 1, buffer.length, stream);
+  free (buffer.data);
+
+  /* Return success. */
+  return 0;
+}
+
+static void
+toc_printf (struct toc_buffer *buffer, const char *template, ...)
+{
+  va_list ap;			/* Arguments; */
+  int length;			/* Length of the formatted text; */
+
+  va_start (ap, template);
+  length = vsnprintf (buffer->data + buffer->length,
+		      buffer->size - buffer->length, template, ap);
+  va_end (ap);
+
+  /* Grow the buffer and format again if it did not fit. */
+  if (length >= 0 && (size_t) length >= buffer->size - buffer->length)
+    {
+      while ((size_t) length >= buffer->size - buffer->length)
+	buffer->size *= 2;
+      buffer->data = xrealloc (buffer->data, buffer->size);
+
+      va_start (ap, template);
+      vsnprintf (buffer->data + buffer->length,
+		 buffer->size - buffer->length, template, ap);
+      va_end (ap);
+    }
+
+  if (length > 0) buffer->length += length;
+}
+
+static void
+toc_quote (struct toc_buffer *buffer, const char *string)
+{
+  int i;			/* Character index; */
+
+  toc_printf (buffer, "\"");
+  for (i = 0; i < 80 && string[i] != '\0'; i++)
+    if (string[i] == '"' || string[i] == '\\')
+      toc_printf (buffer, "\\%c", string[i]);
+    else
+      toc_printf (buffer, "%c", string[i]);
+  toc_printf (buffer, "\"");
+}
+
+static void
+toc_cd_text (struct toc_buffer *buffer, int map_flag, const char *title,
+	     const char *performer, const char *songwriter)
+{
+  toc_printf (buffer, "CD_TEXT {\n");
+  if (map_flag)
+    toc_printf (buffer, "  LANGUAGE_MAP { 0 : EN }\n");
+  toc_printf (buffer, "  LANGUAGE 0 {\n");
+
+  if (title != NULL)
+    {
+      toc_printf (buffer, "    TITLE ");
+      toc_quote (buffer, title);
+      toc_printf (buffer, "\n");
+    }
+  if (performer != NULL)
+    {
+      toc_printf (buffer, "    PERFORMER ");
+      toc_quote (buffer, performer);
+      toc_printf (buffer, "\n");
+    }
+  if (songwriter != NULL)
+    {
+      toc_printf (buffer, "    SONGWRITER ");
+      toc_quote (buffer, songwriter);
+      toc_printf (buffer, "\n");
+    }
+
+  toc_printf (buffer, "  }\n}\n");
+}
+
+static const char *
+toc_msf (long frames)
+{
+  static char msf[64];		/* Formatted time; */
+
+  snprintf (msf, sizeof (msf), "%02ld:%02ld:%02ld", frames / (60 * 75),
+	    frames / 75 % 60, frames % 75);
+
+  return msf;
+}
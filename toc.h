@@ -0,0 +1,74 @@
+/*
+ toc.h -- cdrdao TOC file format;
+
+ Copyright (C) 2013, 2014, 2015 Bruno Félix Rezende Ribeiro <oitofelix@gnu.org>
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       toc.h
+ * \brief      cdrdao TOC file format
+ */
+
+
+#ifndef CCD2CUE_TOC_H
+#define CCD2CUE_TOC_H
+
+#include <stdio.h>
+
+#include "ccd.h"
+#include "cue.h"
+
+/**
+ * Initial size of the buffer ::toc2stream writes into, in bytes.
+ */
+
+#define TOC_BUFFER_SIZE 4096
+
+/**
+ * Convert a _CUE structure_ into a cdrdao _TOC file_ stream.
+ *
+ * \param[in]   cue     _CUE structure_, as made by ::ccd2cue or
+ *                      ::ccd2cue_split;
+ * \param[in]   ccd     _CCD structure_ it was made from;
+ * \param[out]  stream  Output stream;
+ *
+ * \return
+ * + =0  success
+ * + <0  failure
+ *
+ * \note This function exits if any writing error occurs.
+ *
+ * \since 0.3
+ *
+ * This is the counterpart of ::cue2stream for cdrdao.  The files,
+ * data types, _FLAGS_, _ISRC_, _CATALOG_ and text entries come from
+ * CUE, while the length of each track, which a _TOC file_ needs but
+ * a _CUE sheet_ leaves implicit, and the disc type come from CCD.
+ * The _TITLE_, _PERFORMER_ and _SONGWRITER_ entries go inline into
+ * _CD_TEXT_ blocks, in a single language.
+ *
+ * The whole file is formatted into memory and written in one go.
+ *
+ * Raw audio in _BINARY_ files is little endian, while cdrdao takes it
+ * as big endian, so a comment tells to write it with "--swap".
+ * _CD+G_ tracks cannot be described, and are an error.
+ *
+ */
+
+int toc2stream (const struct cue *cue, const struct ccd *ccd, FILE *stream)
+  __attribute__ ((nonnull));
+
+#endif	/* CCD2CUE_TOC_H */
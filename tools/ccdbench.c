@@ -0,0 +1,290 @@
+/*
+ ccdbench.c -- CCD sheet parsing benchmark;
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       ccdbench.c
+ * \brief      CCD sheet parsing benchmark
+ *
+ * This program times the recognition of the entries of a _CCD sheet_
+ * in three ways: by the perfect hash of ccd_key_find, by a linear
+ * scan of ccd_keys, and by the chain of sscanf calls of the lenient
+ * parser.  Then it times the whole parse of each CCD sheet given as
+ * argument, section by section and leniently.  Build it from the top
+ * directory with:
+ *
+ *   gcc -O2 -DNDEBUG -I. -o ccdbench tools/ccdbench.c memory.c errors.c array.c io.c config.c
+ *
+ * and run it as "ccdbench [file.ccd...]".  The best of several runs
+ * is reported, in nanoseconds per line or microseconds per sheet.
+ */
+
+
+#include <time.h>
+
+#include "ccd.c"
+
+
+/** Runs of each measurement, of which the best is taken; */
+#define BENCH_RUNS 5
+
+/** Lookups of each line per run; */
+#define BENCH_LOOKUPS 200000
+
+/** sscanf chains of each line per run, as they are much slower; */
+#define BENCH_CHAINS 20000
+
+/** Parses of each CCD sheet per run; */
+#define BENCH_PARSES 200
+
+/**
+ * A line of a _CCD sheet_ and the section it belongs to.
+ */
+
+struct bench_line
+{
+  const char *line;		/**< Line, "Name=value". */
+  enum ccd_section section;	/**< Section of the line. */
+};
+
+/**
+ * Lines of a typical _CCD sheet_, covering its whole vocabulary.
+ */
+
+static const struct bench_line bench_lines[] =
+  {
+    { "Version=3", CCD_CLONECD },
+    { "TocEntries=6", CCD_DISC },
+    { "Sessions=1", CCD_DISC },
+    { "DataTracksScrambled=0", CCD_DISC },
+    { "CDTextLength=0", CCD_DISC },
+    { "CATALOG=0123456789012", CCD_DISC },
+    { "Entries=1", CCD_CDTEXT },
+    { "PreGapMode=0", CCD_SESSION },
+    { "PreGapSubC=0", CCD_SESSION },
+    { "Session=1", CCD_ENTRY },
+    { "Point=0xa0", CCD_ENTRY },
+    { "ADR=0x01", CCD_ENTRY },
+    { "Control=0x04", CCD_ENTRY },
+    { "TrackNo=0", CCD_ENTRY },
+    { "AMin=0", CCD_ENTRY },
+    { "ASec=0", CCD_ENTRY },
+    { "AFrame=0", CCD_ENTRY },
+    { "ALBA=-150", CCD_ENTRY },
+    { "Zero=0", CCD_ENTRY },
+    { "PMin=1", CCD_ENTRY },
+    { "PSec=0", CCD_ENTRY },
+    { "PFrame=0", CCD_ENTRY },
+    { "PLBA=4350", CCD_ENTRY },
+    { "MODE=0", CCD_TRACK },
+    { "FLAGS=DCP", CCD_TRACK },
+    { "ISRC=USABC1234567", CCD_TRACK },
+    { "INDEX 1=0", CCD_TRACK },
+  };
+
+/** Number of ::bench_lines; */
+#define BENCH_LINES (sizeof (bench_lines) / sizeof (bench_lines[0]))
+
+
+/**
+ * Look an entry up by a linear scan of ::ccd_keys.
+ *
+ * \param[in]  section  Current section;
+ * \param[in]  name     Entry name, not null terminated;
+ * \param[in]  length   Length of NAME;
+ *
+ * \return The entry, or NULL if SECTION has no such entry.
+ *
+ */
+
+static const struct ccd_key *bench_key_scan (enum ccd_section section,
+					     const char *name, size_t length);
+
+/**
+ * Match a line against the entries of the lenient parser, one
+ * sscanf call after another, as ::ccd_parse_lenient does.
+ *
+ * \param[in]  line  Line;
+ *
+ * \return The number of matches.
+ *
+ */
+
+static int bench_sscanf_chain (const char *line);
+
+/**
+ * Tell the seconds elapsed since a start time.
+ *
+ * \param[in]  start  Start time;
+ *
+ * \return The seconds elapsed.
+ *
+ */
+
+static double bench_seconds (clock_t start);
+
+
+int
+main (int argc, char *argv[])
+{
+  size_t length[BENCH_LINES];	/* Length of the name of each line; */
+  double hash = 1e9, scan = 1e9, chain = 1e9; /* Best times; */
+  long hits = 0;		/* Lookups that found an entry; */
+  size_t i;			/* Line index; */
+  int r, k;			/* Run and repetition indexes; */
+
+  for (i = 0; i < BENCH_LINES; i++)
+    {
+      const char *p = bench_lines[i].line; /* Current character; */
+
+      while (isalpha ((unsigned char) *p)) p++;
+      length[i] = p - bench_lines[i].line;
+    }
+
+  for (r = 0; r < BENCH_RUNS; r++)
+    {
+      clock_t start;		/* Start time; */
+      double seconds;		/* Time of this run; */
+
+      start = clock ();
+      for (k = 0; k < BENCH_LOOKUPS; k++)
+	for (i = 0; i < BENCH_LINES; i++)
+	  hits += ccd_key_find (bench_lines[i].section, bench_lines[i].line,
+				length[i]) != NULL;
+      seconds = bench_seconds (start);
+      if (seconds < hash) hash = seconds;
+
+      start = clock ();
+      for (k = 0; k < BENCH_LOOKUPS; k++)
+	for (i = 0; i < BENCH_LINES; i++)
+	  hits += bench_key_scan (bench_lines[i].section, bench_lines[i].line,
+				  length[i]) != NULL;
+      seconds = bench_seconds (start);
+      if (seconds < scan) scan = seconds;
+
+      start = clock ();
+      for (k = 0; k < BENCH_CHAINS; k++)
+	for (i = 0; i < BENCH_LINES; i++)
+	  hits += bench_sscanf_chain (bench_lines[i].line);
+      seconds = bench_seconds (start) * BENCH_LOOKUPS / BENCH_CHAINS;
+      if (seconds < chain) chain = seconds;
+    }
+
+  printf ("perfect hash\t%.1f ns/line\n",
+	  hash / BENCH_LOOKUPS / BENCH_LINES * 1e9);
+  printf ("linear scan\t%.1f ns/line\n",
+	  scan / BENCH_LOOKUPS / BENCH_LINES * 1e9);
+  printf ("sscanf chain\t%.1f ns/line\n",
+	  chain / BENCH_LOOKUPS / BENCH_LINES * 1e9);
+
+  for (k = 1; k < argc; k++)
+    {
+      FILE *stream = fopen (argv[k], "r"); /* CCD sheet stream; */
+      double best[2] = { 1e9, 1e9 }; /* Best times of each parser; */
+      int lenient_flag;		/* Parser; */
+
+      if (stream == NULL)
+	{
+	  perror (argv[k]);
+	  return EXIT_FAILURE;
+	}
+
+      for (lenient_flag = 0; lenient_flag <= 1; lenient_flag++)
+	for (r = 0; r < BENCH_RUNS; r++)
+	  {
+	    clock_t start = clock (); /* Start time; */
+	    double seconds;	/* Time of this run; */
+	    int n;		/* Parse index; */
+
+	    for (n = 0; n < BENCH_PARSES; n++)
+	      {
+		struct ccd ccd;	/* CCD structure filled by stream2ccd; */
+
+		rewind (stream);
+		if (stream2ccd (stream, &ccd, lenient_flag) < 0)
+		  {
+		    error_flush ();
+		    fprintf (stderr, "%s: cannot parse CCD sheet\n", argv[k]);
+		    return EXIT_FAILURE;
+		  }
+		ccd_free (&ccd);
+	      }
+
+	    seconds = bench_seconds (start);
+	    if (seconds < best[lenient_flag]) best[lenient_flag] = seconds;
+	  }
+
+      printf ("%s\tsections %.1f us\tlenient %.1f us\n", argv[k],
+	      best[0] / BENCH_PARSES * 1e6, best[1] / BENCH_PARSES * 1e6);
+      fclose (stream);
+    }
+
+  /* Keep the lookups from being optimized away. */
+  if (hits < 0) printf ("%ld\n", hits);
+
+  return EXIT_SUCCESS;
+}
+
+static const struct ccd_key *
+bench_key_scan (enum ccd_section section, const char *name, size_t length)
+{
+  size_t i;			/* Entry index; */
+
+  for (i = 0; i < CCD_KEYS; i++)
+    if (ccd_keys[i].section == section
+	&& strncmp (ccd_keys[i].name, name, length) == 0
+	&& ccd_keys[i].name[length] == '\0')
+      return &ccd_keys[i];
+
+  return NULL;
+}
+
+static int
+bench_sscanf_chain (const char *line)
+{
+  int x;			/* Value read; */
+
+  return sscanf (line, " Version = %d ", &x)
+    + sscanf (line, " DataTracksScrambled = %d ", &x)
+    + sscanf (line, " CDTextLength = %d ", &x)
+    + sscanf (line, " Sessions = %d ", &x)
+    + sscanf (line, " TocEntries = %d ", &x)
+    + sscanf (line, " Entries = %d ", &x)
+    + sscanf (line, " PreGapMode = %d ", &x)
+    + sscanf (line, " PreGapSubC = %d ", &x)
+    + sscanf (line, " Session = %d ", &x)
+    + sscanf (line, " Point = %x ", &x)
+    + sscanf (line, " ADR = %x ", &x)
+    + sscanf (line, " Control = %x ", &x)
+    + sscanf (line, " TrackNo = %d ", &x)
+    + sscanf (line, " AMin = %d ", &x)
+    + sscanf (line, " ASec = %d ", &x)
+    + sscanf (line, " AFrame = %d ", &x)
+    + sscanf (line, " ALBA = %d ", &x)
+    + sscanf (line, " Zero = %d ", &x)
+    + sscanf (line, " PMin = %d ", &x)
+    + sscanf (line, " PSec = %d ", &x)
+    + sscanf (line, " PFrame = %d ", &x)
+    + sscanf (line, " PLBA = %d ", &x)
+    + sscanf (line, " MODE = %d ", &x)
+    + sscanf (line, " INDEX %d = ", &x);
+}
+
+static double
+bench_seconds (clock_t start)
+{
+  return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
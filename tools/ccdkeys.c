@@ -0,0 +1,154 @@
+/*
+ ccdkeys.c -- Perfect hash generator for the CCD sheet vocabulary;
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3, or (at your option)
+ any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file       ccdkeys.c
+ * \brief      Perfect hash generator for the CCD sheet vocabulary
+ *
+ * This program searches the displacements of the perfect hash that
+ * ccd_key_find uses to look up the entries of ccd_keys, and prints
+ * the ccd_key_displace and ccd_key_slot tables of ccd.c.  Run it
+ * whenever ccd_keys changes, and paste its output over those tables.
+ * It includes ccd.c, so it always sees the current vocabulary and
+ * hash function.  Build it from the top directory with:
+ *
+ *   gcc -I. -o ccdkeys tools/ccdkeys.c memory.c errors.c array.c io.c config.c
+ *
+ * If no displacement fits a bucket, ::CCD_KEY_BUCKETS has to be
+ * raised.
+ */
+
+
+#include "ccd.c"
+
+
+/**
+ * Print an array of bytes as a C initializer.
+ *
+ * \param[in]  name   Array name;
+ * \param[in]  size   Array size, as written in its declaration;
+ * \param[in]  value  Array;
+ * \param[in]  count  Number of elements of VALUE;
+ *
+ */
+
+static void print_table (const char *name, const char *size,
+			 const uint8_t *value, size_t count);
+
+
+int
+main (void)
+{
+  uint32_t hash[CCD_KEYS];	/* Hash of each name; */
+  uint8_t displace[CCD_KEY_BUCKETS]; /* Displacement of each bucket; */
+  uint8_t slot[CCD_KEYS];	/* Entry of each slot; */
+  int used[CCD_KEYS];		/* Whether each slot is taken; */
+  size_t size[CCD_KEY_BUCKETS];	/* Names in each bucket; */
+  size_t order[CCD_KEY_BUCKETS]; /* Buckets from the fullest one; */
+  size_t i, j, b;		/* Entry, slot and bucket indexes; */
+
+  memset (used, 0, sizeof (used));
+  memset (size, 0, sizeof (size));
+  memset (displace, 0, sizeof (displace));
+
+  for (i = 0; i < CCD_KEYS; i++)
+    {
+      if (ccd_keys[i].name == NULL)
+	{
+	  fprintf (stderr, "ccd_keys has fewer entries than CCD_KEYS\n");
+	  return EXIT_FAILURE;
+	}
+      hash[i] = ccd_key_hash (ccd_keys[i].name, strlen (ccd_keys[i].name));
+      size[hash[i] % CCD_KEY_BUCKETS]++;
+    }
+
+  /* Sort the buckets from the fullest one, keeping the order of those
+     of the same size. */
+  for (b = 0; b < CCD_KEY_BUCKETS; b++)
+    {
+      for (j = b; j > 0 && size[order[j - 1]] < size[b]; j--)
+	order[j] = order[j - 1];
+      order[j] = b;
+    }
+
+  /* Give each bucket the least displacement sending its names to free
+     slots, all different. */
+  for (b = 0; b < CCD_KEY_BUCKETS && size[order[b]] > 0; b++)
+    {
+      unsigned int d;		/* Displacement tried; */
+
+      for (d = 0; d <= UINT8_MAX; d++)
+	{
+	  int taken[CCD_KEYS];	/* Slots taken by this bucket; */
+	  int fits = 1;		/* Whether D fits the bucket; */
+
+	  memset (taken, 0, sizeof (taken));
+	  for (i = 0; fits && i < CCD_KEYS; i++)
+	    if (hash[i] % CCD_KEY_BUCKETS == order[b])
+	      {
+		j = ((hash[i] >> 16) + d) % CCD_KEYS;
+		if (used[j] || taken[j]) fits = 0;
+		taken[j] = 1;
+	      }
+
+	  if (!fits) continue;
+
+	  for (i = 0; i < CCD_KEYS; i++)
+	    if (hash[i] % CCD_KEY_BUCKETS == order[b])
+	      {
+		j = ((hash[i] >> 16) + d) % CCD_KEYS;
+		used[j] = 1;
+		slot[j] = i;
+	      }
+	  displace[order[b]] = d;
+	  break;
+	}
+
+      if (d > UINT8_MAX)
+	{
+	  fprintf (stderr, "no displacement fits bucket %lu; "
+		   "raise CCD_KEY_BUCKETS\n", (unsigned long) order[b]);
+	  return EXIT_FAILURE;
+	}
+    }
+
+  print_table ("ccd_key_displace", "CCD_KEY_BUCKETS", displace,
+	       CCD_KEY_BUCKETS);
+  putchar ('\n');
+  print_table ("ccd_key_slot", "CCD_KEYS", slot, CCD_KEYS);
+
+  if (memcmp (displace, ccd_key_displace, sizeof (displace)) == 0
+      && memcmp (slot, ccd_key_slot, sizeof (slot)) == 0)
+    fprintf (stderr, "ccd.c is up to date\n");
+  else
+    fprintf (stderr, "ccd.c is out of date\n");
+
+  return EXIT_SUCCESS;
+}
+
+static void
+print_table (const char *name, const char *size, const uint8_t *value,
+	     size_t count)
+{
+  size_t i;			/* Element index; */
+
+  printf ("static const uint8_t %s[%s] =\n  {\n    ", name, size);
+  for (i = 0; i < count; i++)
+    printf ("%u%s", value[i],
+	    i + 1 == count ? "\n" : (i + 1) % 16 == 0 ? ",\n    " : ", ");
+  printf ("  };\n");
+}